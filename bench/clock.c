@@ -0,0 +1,66 @@
+// Copyright 2025 Anton Zhiyanov, BSD 3-Clause License
+// https://github.com/nalgeon/vaqt
+
+// Clock source benchmarks.
+
+#include <stdio.h>
+
+#include "vaqt.h"
+
+#define N 10000000
+
+// sink keeps the compiler from optimizing away the benchmarked calls.
+static volatile int64_t sink;
+
+// report prints the average time per call.
+static void report(const char* name, Time start, size_t n) {
+    Duration elapsed = time_since(start);
+    printf("%-24s %8.2f ns/op\n", name, (double)elapsed / (double)n);
+}
+
+static void bench_clocks(void) {
+    printf("---\nclock sources:\n");
+
+    Time start = time_now();
+    for (int i = 0; i < N; i++) {
+        sink += time_now().nsec;
+    }
+    report("  time_now", start, N);
+
+    start = time_now();
+    for (int i = 0; i < N; i++) {
+        sink += time_now_coarse().nsec;
+    }
+    report("  time_now_coarse", start, N);
+
+    start = time_now();
+    for (int i = 0; i < N; i++) {
+        sink += time_mono_now().nsec;
+    }
+    report("  time_mono_now", start, N);
+
+    if (time_tsc_init()) {
+        start = time_now();
+        for (int i = 0; i < N; i++) {
+            sink += time_now_tsc().nsec;
+        }
+        report("  time_now_tsc", start, N);
+    } else {
+        printf("  time_now_tsc             not supported\n");
+    }
+
+    if (!time_clock_start(TIME_MILLI)) {
+        printf("  time_now_cached          not supported\n");
+        return;
+    }
+    start = time_now();
+    for (int i = 0; i < N; i++) {
+        sink += time_now_cached().nsec;
+    }
+    report("  time_now_cached", start, N);
+    time_clock_stop();
+}
+
+int main(void) {
+    bench_clocks();
+}
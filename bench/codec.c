@@ -0,0 +1,128 @@
+// Copyright 2025 Anton Zhiyanov, BSD 3-Clause License
+// https://github.com/nalgeon/vaqt
+
+// Time compression benchmarks.
+
+#include <stdio.h>
+
+#include "vaqt.h"
+
+// The columns are small enough to stay in cache,
+// so the benchmarks measure computation rather than memory bandwidth.
+#define N 4096
+#define ROUNDS 250
+
+// sink keeps the compiler from optimizing away the benchmarked calls.
+static volatile int64_t sink;
+
+// report prints the average time per value and the throughput
+// in terms of uncompressed Time values.
+static void report(const char* name, Time start, size_t n) {
+    Duration elapsed = time_since(start);
+    printf("%-24s %8.2f ns/op %8.2f GB/s\n", name, (double)elapsed / (double)n,
+           (double)(n * sizeof(Time)) / (double)elapsed);
+}
+
+// rng_state is the state of the xorshift random number generator.
+static uint64_t rng_state = 88172645463325252ULL;
+
+// rng returns the next pseudo-random number.
+static uint64_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static Time in[N], out[N];
+static uint8_t buf[N * TIME_DOD_MAX_SIZE];
+static uint8_t block_buf[TIME_FOR_HEADER_SIZE + 8 * (N + 1)];
+static size_t idx[N];
+
+// ## Delta-of-delta
+
+static void bench_dod(const char* name) {
+    printf("---\n%s, delta-of-delta:\n", name);
+
+    size_t size = 0;
+    Time start = time_now();
+    for (int r = 0; r < ROUNDS; r++) {
+        TimeDodState st = {0};
+        size = time_dod_encode(&st, in, N, buf, sizeof(buf));
+    }
+    report("  time_dod_encode", start, N * ROUNDS);
+    printf("  %.2f bytes/value, %.1fx smaller than binary\n", (double)size / N,
+           (double)(N * TIME_BINARY_SIZE) / (double)size);
+
+    start = time_now();
+    for (int r = 0; r < ROUNDS; r++) {
+        TimeDodState st = {0};
+        sink += (int64_t)time_dod_decode(&st, buf, size, out, N);
+    }
+    report("  time_dod_decode", start, N * ROUNDS);
+    sink += out[N - 1].sec;
+}
+
+// ## Frame of reference
+
+static void bench_for(const char* name) {
+    printf("---\n%s, frame of reference:\n", name);
+
+    size_t size = 0;
+    Time start = time_now();
+    for (int r = 0; r < ROUNDS; r++) {
+        size = time_for_encode(in, N, block_buf, sizeof(block_buf));
+    }
+    report("  time_for_encode", start, N * ROUNDS);
+    TimeForBlock block;
+    time_for_open(block_buf, size, &block);
+    printf("  %d bits/value, %.1fx smaller than binary\n", block.width,
+           (double)(N * TIME_BINARY_SIZE) / (double)size);
+
+    start = time_now();
+    for (int r = 0; r < ROUNDS; r++) {
+        time_for_decode(&block, out);
+    }
+    report("  time_for_decode", start, N * ROUNDS);
+    sink += out[N - 1].sec;
+
+    // Random access in a shuffled order.
+    for (int i = 0; i < N; i++) {
+        idx[i] = (size_t)(rng() % N);
+    }
+    start = time_now();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < N; i++) {
+            out[i] = time_for_get(&block, idx[i]);
+        }
+    }
+    report("  time_for_get", start, N * ROUNDS);
+    sink += out[N - 1].sec;
+}
+
+int main(void) {
+    // Metric scrapes every 10 seconds.
+    Time t = time_date(2025, TIME_JANUARY, 1, 0, 0, 0, 0, 0);
+    for (int i = 0; i < N; i++) {
+        in[i] = time_add(t, i * 10 * TIME_SECOND);
+    }
+    bench_dod("regular series");
+    bench_for("regular series");
+
+    // Scrapes every 10 seconds with up to a millisecond of jitter.
+    for (int i = 0; i < N; i++) {
+        Duration jitter = (Duration)(rng() % 2000000) - 1000000;
+        in[i] = time_add(t, i * 10 * TIME_SECOND + jitter);
+    }
+    bench_dod("jittered series");
+    bench_for("jittered series");
+
+    // Trades in bursts of values microseconds apart.
+    for (int i = 0; i < N; i++) {
+        uint64_t max_gap = i % 100 == 0 ? 10 * (uint64_t)TIME_SECOND : 5000;
+        t = time_add(t, (Duration)(rng() % max_gap));
+        in[i] = t;
+    }
+    bench_dod("bursty series");
+    bench_for("bursty series");
+}
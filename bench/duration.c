@@ -0,0 +1,114 @@
+// Copyright 2025 Anton Zhiyanov, BSD 3-Clause License
+// https://github.com/nalgeon/vaqt
+
+// Duration benchmarks.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vaqt.h"
+
+#define N 1000000
+
+// sink keeps the compiler from optimizing away the benchmarked calls.
+static volatile int64_t sink;
+
+// report prints the average time per operation.
+static void report(const char* name, Time start, size_t n) {
+    Duration elapsed = time_since(start);
+    printf("%-24s %8.1f ns/op\n", name, (double)elapsed / (double)n);
+}
+
+// ## Reference implementations
+
+// ref_parse is a typical strtod-based duration parser
+// duration_parse is measured against.
+static Duration ref_parse(const char* s) {
+    double total = 0;
+    while (*s) {
+        char* end;
+        double v = strtod(s, &end);
+        if (end == s) {
+            return 0;
+        }
+        s = end;
+        double unit;
+        if (strncmp(s, "ns", 2) == 0) {
+            unit = 1, s += 2;
+        } else if (strncmp(s, "us", 2) == 0) {
+            unit = 1e3, s += 2;
+        } else if (strncmp(s, "ms", 2) == 0) {
+            unit = 1e6, s += 2;
+        } else if (*s == 's') {
+            unit = 1e9, s += 1;
+        } else if (*s == 'm') {
+            unit = 60e9, s += 1;
+        } else if (*s == 'h') {
+            unit = 3600e9, s += 1;
+        } else {
+            return 0;
+        }
+        total += v * unit;
+    }
+    return (Duration)total;
+}
+
+// ## Formatting
+
+static void bench_fmt(void) {
+    printf("---\nduration formatting:\n");
+
+    // A mix of sub-second, second, minute and hour durations.
+    Duration ds[] = {
+        1500 * TIME_MICRO,
+        3300 * TIME_MILLI,
+        4 * TIME_MINUTE + 5001 * TIME_MILLI,
+        5 * TIME_HOUR + 6 * TIME_MINUTE + 7 * TIME_SECOND + 123456789,
+    };
+    size_t nds = sizeof(ds) / sizeof(ds[0]);
+    char buf[32];
+
+    Time start = time_now();
+    for (int i = 0; i < N; i++) {
+        Duration d = ds[i % nds];
+        sink += snprintf(buf, sizeof(buf), "%.9fs", duration_to_seconds(d));
+    }
+    report("  snprintf %.9f", start, N);
+
+    start = time_now();
+    for (int i = 0; i < N; i++) {
+        Duration d = ds[i % nds];
+        sink += (int64_t)duration_fmt(d, buf, sizeof(buf));
+    }
+    report("  duration_fmt", start, N);
+}
+
+// ## Parsing
+
+static void bench_parse(void) {
+    printf("---\nduration parsing:\n");
+
+    const char* strs[] = {"250ms", "1.5us", "1h30m", "5h6m7.123456789s"};
+    size_t lens[] = {5, 5, 5, 16};
+    size_t nstrs = sizeof(strs) / sizeof(strs[0]);
+
+    Time start = time_now();
+    for (int i = 0; i < N; i++) {
+        sink += ref_parse(strs[i % nstrs]);
+    }
+    report("  strtod", start, N);
+
+    start = time_now();
+    for (int i = 0; i < N; i++) {
+        Duration d = 0;
+        duration_parse(strs[i % nstrs], lens[i % nstrs], &d);
+        sink += d;
+    }
+    report("  duration_parse", start, N);
+}
+
+int main(void) {
+    bench_fmt();
+    bench_parse();
+}
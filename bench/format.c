@@ -0,0 +1,537 @@
+// Copyright 2025 Anton Zhiyanov, BSD 3-Clause License
+// https://github.com/nalgeon/vaqt
+
+// Time formatting benchmarks.
+
+// strptime is a POSIX extension hidden by -std=c11.
+#if !defined(_WIN32)
+#define _XOPEN_SOURCE 700
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "vaqt.h"
+
+#define N 1000000
+
+// sink keeps the compiler from optimizing away the benchmarked calls.
+static volatile int64_t sink;
+
+// report prints the average time per operation.
+static void report(const char* name, Time start, size_t n) {
+    Duration elapsed = time_since(start);
+    printf("%-24s %8.1f ns/op\n", name, (double)elapsed / (double)n);
+}
+
+// ## Reference implementations
+
+// ref_parse is the sscanf-based time_parse implementation
+// the current one is measured against.
+static Time ref_parse(const char* value) {
+    Time zero = {0, 0};
+    size_t len = strlen(value);
+    if (len < 8 || len > 35) {
+        return zero;
+    }
+
+    int year = 1, month = 1, day = 1, hour = 0, min = 0, sec = 0, nsec = 0, offset_sec = 0;
+    char tz[7] = "";
+
+    bool ok = false;
+    if (len == 35) {
+        ok = sscanf(value, "%d-%d-%dT%d:%d:%d.%d%6s", &year, &month, &day, &hour, &min, &sec,
+                    &nsec, tz) == 8;
+    } else if (len == 30) {
+        ok = sscanf(value, "%d-%d-%dT%d:%d:%d.%dZ", &year, &month, &day, &hour, &min, &sec,
+                    &nsec) == 7;
+    } else if (len == 25) {
+        ok = sscanf(value, "%d-%d-%dT%d:%d:%d%6s", &year, &month, &day, &hour, &min, &sec,
+                    tz) == 7;
+    } else if (len == 19 || len == 20) {
+        ok = sscanf(value, "%d-%d-%d%*c%d:%d:%d", &year, &month, &day, &hour, &min, &sec) == 6;
+    } else if (len == 10) {
+        ok = sscanf(value, "%d-%d-%d", &year, &month, &day) == 3;
+    } else if (len == 8) {
+        ok = sscanf(value, "%d:%d:%d", &hour, &min, &sec) == 3;
+    }
+    if (!ok) {
+        return zero;
+    }
+
+    if (tz[0] != '\0') {
+        int sign = (tz[0] == '-') ? -1 : 1;
+        offset_sec = ((tz[1] - '0') * 10 + (tz[2] - '0')) * 3600 * sign;
+        offset_sec += ((tz[4] - '0') * 10 + (tz[5] - '0')) * 60 * sign;
+    }
+    return time_date(year, (enum Month)month, day, hour, min, sec, nsec, offset_sec);
+}
+
+// ref_fmt_iso is the snprintf-based time_fmt_iso implementation
+// the current one is measured against.
+static size_t ref_fmt_iso(Time t, int offset_sec, char* buf, size_t size) {
+    int year, day, hour, min, sec;
+    enum Month month;
+    if (offset_sec != 0) {
+        t = time_add(t, offset_sec * TIME_SECOND);
+    }
+    time_get_date(t, &year, &month, &day);
+    time_get_clock(t, &hour, &min, &sec);
+    if (offset_sec == 0) {
+        if (t.nsec == 0) {
+            return snprintf(buf, size, "%04d-%02d-%02dT%02d:%02d:%02dZ", year, month, day, hour,
+                            min, sec);
+        }
+        return snprintf(buf, size, "%04d-%02d-%02dT%02d:%02d:%02d.%09dZ", year, month, day, hour,
+                        min, sec, t.nsec);
+    }
+    int ofhour = offset_sec / 3600;
+    int ofmin = (offset_sec % 3600) / 60;
+    if (ofmin < 0) {
+        ofmin = -ofmin;
+    }
+    if (t.nsec == 0) {
+        return snprintf(buf, size, "%04d-%02d-%02dT%02d:%02d:%02d%+03d:%02d", year, month, day,
+                        hour, min, sec, ofhour, ofmin);
+    }
+    return snprintf(buf, size, "%04d-%02d-%02dT%02d:%02d:%02d.%09d%+03d:%02d", year, month, day,
+                    hour, min, sec, t.nsec, ofhour, ofmin);
+}
+
+// ref_fmt_datetime is the snprintf-based time_fmt_datetime implementation.
+static size_t ref_fmt_datetime(Time t, int offset_sec, char* buf, size_t size) {
+    int year, day, hour, min, sec;
+    enum Month month;
+    if (offset_sec != 0) {
+        t = time_add(t, offset_sec * TIME_SECOND);
+    }
+    time_get_date(t, &year, &month, &day);
+    time_get_clock(t, &hour, &min, &sec);
+    return snprintf(buf, size, "%04d-%02d-%02d %02d:%02d:%02d", year, month, day, hour, min, sec);
+}
+
+// ref_fmt_millis formats t like the "2006-01-02T15:04:05.000Z07:00" layout
+// using snprintf.
+static size_t ref_fmt_millis(Time t, int offset_sec, char* buf, size_t size) {
+    int year, day, hour, min, sec;
+    enum Month month;
+    if (offset_sec != 0) {
+        t = time_add(t, offset_sec * TIME_SECOND);
+    }
+    time_get_date(t, &year, &month, &day);
+    time_get_clock(t, &hour, &min, &sec);
+    if (offset_sec == 0) {
+        return snprintf(buf, size, "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ", year, month, day, hour,
+                        min, sec, t.nsec / 1000000);
+    }
+    return snprintf(buf, size, "%04d-%02d-%02dT%02d:%02d:%02d.%03d%+03d:%02d", year, month, day,
+                    hour, min, sec, t.nsec / 1000000, offset_sec / 3600,
+                    (offset_sec < 0 ? -offset_sec : offset_sec) % 3600 / 60);
+}
+
+// ref_fmt_rfc1123 formats t like the "Mon, 02 Jan 2006 15:04:05 MST" layout
+// using strftime.
+static size_t ref_fmt_rfc1123(Time t, char* buf, size_t size) {
+    struct tm tm = time_to_tm(t, 0);
+    return strftime(buf, size, "%a, %d %b %Y %H:%M:%S UTC", &tm);
+}
+
+#if !defined(_WIN32)
+// ref_parse_clf parses a "02/Jan/2006:15:04:05 -0700" string using strptime.
+static Time ref_parse_clf(const char* value) {
+    struct tm tm = {0};
+    const char* rest = strptime(value, "%d/%b/%Y:%H:%M:%S ", &tm);
+    if (rest == NULL || strlen(rest) != 5) {
+        return (Time){0, 0};
+    }
+    int sign = rest[0] == '-' ? -1 : 1;
+    int offset_sec = sign * (((rest[1] - '0') * 10 + (rest[2] - '0')) * 3600 +
+                             ((rest[3] - '0') * 10 + (rest[4] - '0')) * 60);
+    return time_tm(tm, offset_sec);
+}
+
+// ref_parse_http parses a "Mon, 02 Jan 2006 15:04:05 GMT" string using strptime.
+static Time ref_parse_http(const char* value) {
+    struct tm tm = {0};
+    const char* rest = strptime(value, "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    if (rest == NULL || *rest != '\0') {
+        return (Time){0, 0};
+    }
+    return time_tm(tm, 0);
+}
+#endif
+
+// ## Formatting
+
+typedef struct {
+    const char* name;
+    int offset_sec;
+    int nsec;
+} FormatCase;
+
+static const FormatCase fmt_cases[] = {
+    {"nsec, UTC", 0, 666777888},
+    {"nsec, +07:00", 7 * 3600, 666777888},
+    {"sec, UTC", 0, 0},
+};
+
+static void bench_fmt_iso(void) {
+    printf("---\ntime_fmt_iso:\n");
+    char buf[64];
+    for (size_t i = 0; i < sizeof(fmt_cases) / sizeof(fmt_cases[0]); i++) {
+        FormatCase c = fmt_cases[i];
+        Time t = time_date(2011, TIME_NOVEMBER, 18, 15, 56, 35, c.nsec, 0);
+        printf("%s\n", c.name);
+
+        Time start = time_now();
+        for (int j = 0; j < N; j++) {
+            t.sec += 1;
+            sink += ref_fmt_iso(t, c.offset_sec, buf, sizeof(buf));
+        }
+        report("  snprintf", start, N);
+
+        start = time_now();
+        for (int j = 0; j < N; j++) {
+            t.sec += 1;
+            sink += time_fmt_iso(t, c.offset_sec, buf, sizeof(buf));
+        }
+        report("  time_fmt_iso", start, N);
+    }
+}
+
+static void bench_fmt_iso_prec(void) {
+    printf("---\ntime_fmt_iso_prec:\n");
+    char buf[64];
+    Time t = time_date(2011, TIME_NOVEMBER, 18, 15, 56, 35, 666777888, 0);
+    int precs[] = {3, 6, TIME_PREC_TRIM};
+    const char* names[] = {"  prec = 3", "  prec = 6", "  prec = TIME_PREC_TRIM"};
+    for (size_t i = 0; i < sizeof(precs) / sizeof(precs[0]); i++) {
+        Time start = time_now();
+        for (int j = 0; j < N; j++) {
+            t.sec += 1;
+            sink += time_fmt_iso_prec(t, 0, precs[i], buf, sizeof(buf));
+        }
+        report(names[i], start, N);
+    }
+}
+
+static void bench_fmt_iso_batch(void) {
+    printf("---\ntime_fmt_iso_batch:\n");
+    enum { ROWS = 1024 };
+    static Time in[ROWS];
+    static char out[ROWS * 64];
+    static int32_t offsets[ROWS + 1];
+    Time t = time_date(2011, TIME_NOVEMBER, 18, 15, 56, 35, 666777888, 0);
+    for (size_t i = 0; i < ROWS; i++) {
+        in[i] = time_add(t, (Duration)i * 7919 * TIME_SECOND);
+    }
+    printf("prec = 3, offset = +07:00 (x%d)\n", ROWS);
+
+    Time start = time_now();
+    for (int j = 0; j < N / ROWS; j++) {
+        char* p = out;
+        for (size_t i = 0; i < ROWS; i++) {
+            char buf[64];
+            size_t n = time_fmt_iso_prec(in[i], 7 * 3600, 3, buf, sizeof(buf));
+            memcpy(p, buf, n);
+            p += n;
+            offsets[i + 1] = (int32_t)(p - out);
+        }
+        sink += p - out;
+    }
+    report("  time_fmt_iso_prec", start, (N / ROWS) * ROWS);
+
+    start = time_now();
+    for (int j = 0; j < N / ROWS; j++) {
+        sink += time_fmt_iso_batch(in, ROWS, 7 * 3600, 3, out, sizeof(out), offsets);
+    }
+    report("  time_fmt_iso_batch", start, (N / ROWS) * ROWS);
+
+    start = time_now();
+    for (int j = 0; j < N / ROWS; j++) {
+        sink += time_fmt_iso_batch(in, ROWS, 7 * 3600, 3, out, sizeof(out), NULL);
+    }
+    report("  fixed width", start, (N / ROWS) * ROWS);
+}
+
+static void bench_fmt_iso_cached(void) {
+    printf("---\ntime_fmt_iso_cached:\n");
+    printf("increasing timestamps, 10us apart, prec = 6\n");
+    char buf[64];
+    Time t = time_date(2011, TIME_NOVEMBER, 18, 15, 56, 35, 666777888, 0);
+    Time start = time_now();
+    for (int j = 0; j < N; j++) {
+        t = time_add(t, 10 * TIME_MICRO);
+        sink += time_fmt_iso_prec(t, 7 * 3600, 6, buf, sizeof(buf));
+    }
+    report("  time_fmt_iso_prec", start, N);
+
+    TimeFmtCache cache = {0};
+    t = time_date(2011, TIME_NOVEMBER, 18, 15, 56, 35, 666777888, 0);
+    start = time_now();
+    for (int j = 0; j < N; j++) {
+        t = time_add(t, 10 * TIME_MICRO);
+        sink += time_fmt_iso_cached(&cache, t, 7 * 3600, 6, buf, sizeof(buf));
+    }
+    report("  time_fmt_iso_cached", start, N);
+}
+
+static void bench_fmt_datetime(void) {
+    printf("---\ntime_fmt_datetime:\n");
+    char buf[64];
+    Time t = time_date(2011, TIME_NOVEMBER, 18, 15, 56, 35, 0, 0);
+
+    Time start = time_now();
+    for (int j = 0; j < N; j++) {
+        t.sec += 1;
+        sink += ref_fmt_datetime(t, 0, buf, sizeof(buf));
+    }
+    report("  snprintf", start, N);
+
+    start = time_now();
+    for (int j = 0; j < N; j++) {
+        t.sec += 1;
+        sink += time_fmt_datetime(t, 0, buf, sizeof(buf));
+    }
+    report("  time_fmt_datetime", start, N);
+}
+
+static void bench_fmt_layout(void) {
+    printf("---\ntime_fmt_layout:\n");
+    char buf[64];
+    Time t = time_date(2011, TIME_NOVEMBER, 18, 15, 56, 35, 666777888, 0);
+
+    TimeLayout millis;
+    time_layout_compile("2006-01-02T15:04:05.000Z07:00", &millis);
+    printf("2006-01-02T15:04:05.000Z07:00\n");
+
+    Time start = time_now();
+    for (int j = 0; j < N; j++) {
+        t.sec += 1;
+        sink += ref_fmt_millis(t, 7 * 3600, buf, sizeof(buf));
+    }
+    report("  snprintf", start, N);
+
+    start = time_now();
+    for (int j = 0; j < N; j++) {
+        t.sec += 1;
+        sink += time_fmt_layout(t, 7 * 3600, &millis, buf, sizeof(buf));
+    }
+    report("  time_fmt_layout", start, N);
+
+    TimeLayout rfc1123;
+    time_layout_compile("Mon, 02 Jan 2006 15:04:05 MST", &rfc1123);
+    printf("Mon, 02 Jan 2006 15:04:05 MST\n");
+
+    start = time_now();
+    for (int j = 0; j < N; j++) {
+        t.sec += 1;
+        sink += ref_fmt_rfc1123(t, buf, sizeof(buf));
+    }
+    report("  strftime", start, N);
+
+    start = time_now();
+    for (int j = 0; j < N; j++) {
+        t.sec += 1;
+        sink += time_fmt_layout(t, 0, &rfc1123, buf, sizeof(buf));
+    }
+    report("  time_fmt_layout", start, N);
+}
+
+// ## Parsing
+
+static const char* parse_inputs[] = {
+    "2011-11-18T15:56:35.666777888+07:00",
+    "2011-11-18T15:56:35.666777888Z",
+    "2011-11-18T15:56:35+07:00",
+    "2011-11-18T15:56:35Z",
+    "2011-11-18 15:56:35",
+    "2011-11-18",
+};
+
+static void bench_parse(void) {
+    printf("---\ntime_parse:\n");
+    for (size_t i = 0; i < sizeof(parse_inputs) / sizeof(parse_inputs[0]); i++) {
+        const char* s = parse_inputs[i];
+        printf("%s\n", s);
+
+        Time start = time_now();
+        for (int j = 0; j < N; j++) {
+            sink += ref_parse(s).sec;
+        }
+        report("  sscanf", start, N);
+
+        start = time_now();
+        for (int j = 0; j < N; j++) {
+            sink += time_parse(s).sec;
+        }
+        report("  time_parse", start, N);
+    }
+}
+
+// fmt_parse_input formats t in the layout of parse_inputs[k].
+static size_t fmt_parse_input(size_t k, Time t, char* buf, size_t size) {
+    switch (k) {
+        case 0:
+            return time_fmt_iso_prec(t, 7 * 3600, 9, buf, size);
+        case 1:
+            return time_fmt_iso_prec(t, 0, 9, buf, size);
+        case 2:
+            return time_fmt_iso_prec(t, 7 * 3600, 0, buf, size);
+        case 3:
+            return time_fmt_iso_prec(t, 0, 0, buf, size);
+        case 4:
+            return time_fmt_datetime(t, 0, buf, size);
+        default:
+            return time_fmt_date(t, 0, buf, size);
+    }
+}
+
+static void bench_parse_column(void) {
+    printf("---\ntime_parse_n (column of distinct values):\n");
+    enum { ROWS = 1024 };
+    static char bufs[ROWS][40];
+    static size_t lens[ROWS];
+    Time t = time_date(2011, TIME_NOVEMBER, 18, 15, 56, 35, 666777888, 0);
+    for (size_t k = 0; k < sizeof(parse_inputs) / sizeof(parse_inputs[0]); k++) {
+        for (size_t i = 0; i < ROWS; i++) {
+            Time u = time_add(t, (Duration)i * 7919 * TIME_SECOND + (Duration)i * 1013);
+            lens[i] = fmt_parse_input(k, u, bufs[i], sizeof(bufs[i]));
+        }
+        printf("%s\n", bufs[0]);
+
+        Time start = time_now();
+        for (int j = 0; j < N / ROWS; j++) {
+            for (size_t i = 0; i < ROWS; i++) {
+                Time got;
+                sink += time_parse_n(bufs[i], lens[i], &got) + got.sec;
+            }
+        }
+        report("  time_parse_n", start, (N / ROWS) * ROWS);
+    }
+}
+
+static void bench_parse_layout(void) {
+    printf("---\ntime_parse_layout:\n");
+    const char* s = "04/Feb/2010:21:00:57 -0800";
+    size_t len = strlen(s);
+    TimeLayout layout;
+    time_layout_compile("02/Jan/2006:15:04:05 -0700", &layout);
+    printf("%s\n", s);
+
+#if !defined(_WIN32)
+    Time start = time_now();
+    for (int j = 0; j < N; j++) {
+        sink += ref_parse_clf(s).sec;
+    }
+    report("  strptime", start, N);
+#endif
+
+    Time start_layout = time_now();
+    for (int j = 0; j < N; j++) {
+        Time t = {0, 0};
+        sink += time_parse_layout(s, len, &layout, &t, NULL) + t.sec;
+    }
+    report("  time_parse_layout", start_layout, N);
+}
+
+static void bench_parse_batch(void) {
+    printf("---\ntime_parse_batch:\n");
+    enum { ROWS = 1024 };
+    static char bufs[ROWS][40];
+    static const char* strs[ROWS];
+    static size_t lens[ROWS];
+    static Time out[ROWS];
+    static uint8_t valid[ROWS / 8];
+    Time t = time_date(2011, TIME_NOVEMBER, 18, 15, 56, 35, 666777888, 0);
+    for (size_t i = 0; i < ROWS; i++) {
+        Time u = time_add(t, (Duration)i * 7919 * TIME_SECOND);
+        lens[i] = time_fmt_iso(u, 7 * 3600, bufs[i], sizeof(bufs[i]));
+        strs[i] = bufs[i];
+    }
+    printf("%s (x%d)\n", strs[0], ROWS);
+
+    Time start = time_now();
+    for (int j = 0; j < N / ROWS; j++) {
+        for (size_t i = 0; i < ROWS; i++) {
+            sink += time_parse_n(strs[i], lens[i], &out[i]);
+        }
+    }
+    report("  time_parse_n", start, (N / ROWS) * ROWS);
+
+    start = time_now();
+    for (int j = 0; j < N / ROWS; j++) {
+        sink += time_parse_batch(strs, lens, ROWS, out, valid);
+    }
+    report("  time_parse_batch", start, (N / ROWS) * ROWS);
+
+    static char data[ROWS * 40];
+    static int32_t offsets[ROWS + 1];
+    for (size_t i = 0; i < ROWS; i++) {
+        memcpy(data + offsets[i], strs[i], lens[i]);
+        offsets[i + 1] = offsets[i] + (int32_t)lens[i];
+    }
+    start = time_now();
+    for (int j = 0; j < N / ROWS; j++) {
+        sink += time_parse_batch_offsets(data, offsets, ROWS, out, valid);
+    }
+    report("  parse_batch_offsets", start, (N / ROWS) * ROWS);
+}
+
+static void bench_http(void) {
+    printf("---\nHTTP dates:\n");
+    char buf[64];
+    Time t = time_date(1994, TIME_NOVEMBER, 6, 8, 49, 37, 0, 0);
+    Time start = time_now();
+    for (int j = 0; j < N; j++) {
+        t.nsec = j % 1000 * 1000000;
+        sink += ref_fmt_rfc1123(t, buf, sizeof(buf));
+    }
+    report("  strftime", start, N);
+
+    start = time_now();
+    for (int j = 0; j < N; j++) {
+        t.nsec = j % 1000 * 1000000;
+        sink += time_fmt_http(t, buf, sizeof(buf));
+    }
+    report("  time_fmt_http", start, N);
+
+    start = time_now();
+    for (int j = 0; j < N; j++) {
+        t.nsec = j % 1000 * 1000000;
+        sink += time_fmt_http_cached(t, buf, sizeof(buf));
+    }
+    report("  time_fmt_http_cached", start, N);
+
+    const char* s = "Sun, 06 Nov 1994 08:49:37 GMT";
+    size_t len = strlen(s);
+#if !defined(_WIN32)
+    start = time_now();
+    for (int j = 0; j < N; j++) {
+        sink += ref_parse_http(s).sec;
+    }
+    report("  strptime", start, N);
+#endif
+
+    start = time_now();
+    for (int j = 0; j < N; j++) {
+        Time got = {0, 0};
+        sink += time_parse_http(s, len, &got) + got.sec;
+    }
+    report("  time_parse_http", start, N);
+}
+
+int main(void) {
+    bench_fmt_iso();
+    bench_fmt_iso_prec();
+    bench_fmt_iso_batch();
+    bench_fmt_iso_cached();
+    bench_fmt_datetime();
+    bench_fmt_layout();
+    bench_parse();
+    bench_parse_column();
+    bench_parse_layout();
+    bench_parse_batch();
+    bench_http();
+}
@@ -0,0 +1,224 @@
+// Copyright 2025 Anton Zhiyanov, BSD 3-Clause License
+// https://github.com/nalgeon/vaqt
+
+// Time benchmarks.
+
+#include <stdio.h>
+
+#include "vaqt.h"
+
+// The columns are small enough to stay in cache,
+// so the benchmarks measure computation rather than memory bandwidth.
+#define N 4096
+#define ROUNDS 250
+
+// sink keeps the compiler from optimizing away the benchmarked calls.
+static volatile int64_t sink;
+
+// report prints the average time per element.
+static void report(const char* name, Time start, size_t n) {
+    Duration elapsed = time_since(start);
+    printf("%-24s %8.2f ns/op\n", name, (double)elapsed / (double)n);
+}
+
+static Time in[N], out[N];
+static int col1[N], col2[N], col3[N];
+static uint8_t blobs[N * TIME_BINARY_SIZE];
+static int year[N], month[N], day[N], hour[N], min[N], sec[N], nsec[N];
+
+// report_bytes prints the average time per element and the throughput.
+static void report_bytes(const char* name, Time start, size_t n, size_t bytes) {
+    Duration elapsed = time_since(start);
+    printf("%-30s %8.2f ns/op %8.2f GB/s\n", name, (double)elapsed / (double)n,
+           (double)bytes / (double)elapsed);
+}
+
+// fill_input fills the input column with increasing timestamps
+// spread over several years, and the date columns with their parts.
+static void fill_input(void) {
+    for (int i = 0; i < N; i++) {
+        in[i] = time_unix(1600000000 + (int64_t)i * 77317, i);
+    }
+    time_get_date_batch(in, N, year, month, day);
+    time_get_clock_batch(in, N, hour, min, sec);
+    for (int i = 0; i < N; i++) {
+        nsec[i] = time_get_nano(in[i]);
+    }
+}
+
+// ## Batch constructors
+
+static void bench_date_batch(void) {
+    printf("---\ntime_date_batch:\n");
+
+    Time start = time_now();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < N; i++) {
+            out[i] = time_date(year[i], month[i], day[i], hour[i], min[i], sec[i], nsec[i], 0);
+        }
+    }
+    report("  time_date", start, N * ROUNDS);
+    sink += out[N - 1].sec;
+
+    start = time_now();
+    for (int r = 0; r < ROUNDS; r++) {
+        time_date_batch(year, month, day, hour, min, sec, nsec, NULL, 0, N, out);
+    }
+    report("  time_date_batch", start, N * ROUNDS);
+    sink += out[N - 1].sec;
+}
+
+// ## Batch time parts
+
+static void bench_get_date_batch(void) {
+    printf("---\ntime_get_date_batch:\n");
+
+    Time start = time_now();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < N; i++) {
+            enum Month m;
+            time_get_date(in[i], &col1[i], &m, &col3[i]);
+            col2[i] = m;
+        }
+    }
+    report("  time_get_date", start, N * ROUNDS);
+    sink += col1[N - 1] + col2[N - 1] + col3[N - 1];
+
+    start = time_now();
+    for (int r = 0; r < ROUNDS; r++) {
+        time_get_date_batch(in, N, col1, col2, col3);
+    }
+    report("  time_get_date_batch", start, N * ROUNDS);
+    sink += col1[N - 1] + col2[N - 1] + col3[N - 1];
+}
+
+static void bench_get_clock_batch(void) {
+    printf("---\ntime_get_clock_batch:\n");
+
+    Time start = time_now();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < N; i++) {
+            time_get_clock(in[i], &col1[i], &col2[i], &col3[i]);
+        }
+    }
+    report("  time_get_clock", start, N * ROUNDS);
+    sink += col1[N - 1] + col2[N - 1] + col3[N - 1];
+
+    start = time_now();
+    for (int r = 0; r < ROUNDS; r++) {
+        time_get_clock_batch(in, N, col1, col2, col3);
+    }
+    report("  time_get_clock_batch", start, N * ROUNDS);
+    sink += col1[N - 1] + col2[N - 1] + col3[N - 1];
+}
+
+static void bench_get_weekday_batch(void) {
+    printf("---\ntime_get_weekday_batch:\n");
+
+    Time start = time_now();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < N; i++) {
+            col1[i] = time_get_weekday(in[i]);
+        }
+    }
+    report("  time_get_weekday", start, N * ROUNDS);
+    sink += col1[N - 1];
+
+    start = time_now();
+    for (int r = 0; r < ROUNDS; r++) {
+        time_get_weekday_batch(in, N, col1);
+    }
+    report("  time_get_weekday_batch", start, N * ROUNDS);
+    sink += col1[N - 1];
+}
+
+// ## Arithmetic
+
+static void bench_add_period(void) {
+    printf("---\ntime_add_period:\n");
+
+    // P1Y2M3DT4H5M6.5S
+    Period p = {1, 2, 3, 4 * TIME_HOUR + 5 * TIME_MINUTE + 6500 * TIME_MILLI};
+
+    Time start = time_now();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < N; i++) {
+            Time t = time_add_date(in[i], p.years, 0, 0);
+            t = time_add_date(t, 0, p.months, 0);
+            t = time_add_date(t, 0, 0, p.days);
+            out[i] = time_add(t, p.duration);
+        }
+    }
+    report("  time_add_date x3", start, N * ROUNDS);
+    sink += out[N - 1].sec;
+
+    start = time_now();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < N; i++) {
+            out[i] = time_add_period(in[i], p);
+        }
+    }
+    report("  time_add_period", start, N * ROUNDS);
+    sink += out[N - 1].sec;
+
+    // P1DT12H (no years or months)
+    p = (Period){0, 0, 1, 12 * TIME_HOUR};
+    start = time_now();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < N; i++) {
+            out[i] = time_add_period(in[i], p);
+        }
+    }
+    report("  time_add_period (days)", start, N * ROUNDS);
+    sink += out[N - 1].sec;
+}
+
+// ## Marshaling
+
+static void bench_marshal_binary_batch(void) {
+    printf("---\ntime_marshal_binary_batch:\n");
+    size_t bytes = (size_t)N * ROUNDS * TIME_BINARY_SIZE;
+
+    Time start = time_now();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < N; i++) {
+            time_marshal_binary(in[i], blobs + i * TIME_BINARY_SIZE);
+        }
+    }
+    report_bytes("  time_marshal_binary", start, N * ROUNDS, bytes);
+    sink += blobs[N * TIME_BINARY_SIZE - 1];
+
+    start = time_now();
+    for (int r = 0; r < ROUNDS; r++) {
+        time_marshal_binary_batch(in, N, blobs);
+    }
+    report_bytes("  time_marshal_binary_batch", start, N * ROUNDS, bytes);
+    sink += blobs[N * TIME_BINARY_SIZE - 1];
+
+    printf("time_unmarshal_binary_batch:\n");
+    start = time_now();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < N; i++) {
+            out[i] = time_unmarshal_binary(blobs + i * TIME_BINARY_SIZE);
+        }
+    }
+    report_bytes("  time_unmarshal_binary", start, N * ROUNDS, bytes);
+    sink += out[N - 1].sec;
+
+    start = time_now();
+    for (int r = 0; r < ROUNDS; r++) {
+        time_unmarshal_binary_batch(blobs, N, out);
+    }
+    report_bytes("  time_unmarshal_binary_batch", start, N * ROUNDS, bytes);
+    sink += out[N - 1].sec;
+}
+
+int main(void) {
+    fill_input();
+    bench_date_batch();
+    bench_get_date_batch();
+    bench_get_clock_batch();
+    bench_get_weekday_batch();
+    bench_add_period();
+    bench_marshal_binary_batch();
+}
@@ -0,0 +1,483 @@
+// Copyright 2025 Anton Zhiyanov, BSD 3-Clause License
+// https://github.com/nalgeon/vaqt
+
+// Coarse, cached, monotonic and TSC clock sources.
+
+// clock_gettime, CLOCK_REALTIME_COARSE and nanosleep are POSIX extensions
+// hidden by -std=c11 (macOS exposes them by default).
+#if !defined(_WIN32) && !defined(__APPLE__) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "vaqt.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+// The TSC clock needs an x86-64 CPU, compiler intrinsics and atomics.
+#if (defined(__x86_64__) || defined(_M_X64)) && !defined(__STDC_NO_ATOMICS__) && \
+    (defined(__GNUC__) || defined(_MSC_VER))
+#define HAS_TSC_CLOCK 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+#else
+#define HAS_TSC_CLOCK 0
+#endif
+
+// The cached clock needs atomics and a way to run the ticker thread.
+#if !defined(__STDC_NO_ATOMICS__) && \
+    (defined(_WIN32) || (defined(_POSIX_THREADS) && _POSIX_THREADS > 0))
+#define HAS_CACHED_CLOCK 1
+#else
+#define HAS_CACHED_CLOCK 0
+#endif
+
+#if HAS_CACHED_CLOCK || HAS_TSC_CLOCK
+#include <stdatomic.h>
+#endif
+
+// ## Coarse clock
+
+// time_now_coarse returns the current time in UTC with the resolution
+// of the system tick (typically 1-4 ms), which is cheaper to read than time_now.
+// Falls back to time_now on platforms without a coarse clock.
+Time time_now_coarse(void) {
+#if defined(CLOCK_REALTIME_COARSE)
+    struct timespec ts;
+    if (clock_gettime(CLOCK_REALTIME_COARSE, &ts) == 0) {
+        return time_unix(ts.tv_sec, ts.tv_nsec);
+    }
+#endif
+    return time_now();
+}
+
+// ## Cached clock
+
+#if HAS_CACHED_CLOCK
+
+// cached_nsec holds the latest tick as Unix nanoseconds,
+// or 0 when the ticker is not running.
+static _Atomic int64_t cached_nsec;
+
+// Ticker states. time_clock_start and time_clock_stop claim the ticker
+// with a compare-exchange on its state, so concurrent calls cannot race.
+enum {
+    TICKER_STOPPED,   // no thread
+    TICKER_STARTING,  // time_clock_start is spawning the thread
+    TICKER_RUNNING,   // the thread is running
+    TICKER_STOPPING,  // time_clock_stop is waiting for the thread to exit
+};
+
+// ticker_state holds the current ticker state.
+static atomic_int ticker_state;
+
+// ticker_settle_wait is how long time_clock_start and time_clock_stop sleep
+// between checks while another thread is starting or stopping the ticker.
+static const Duration ticker_settle_wait = 100000;
+
+// ticker_interval is the time between ticks.
+static Duration ticker_interval;
+
+// ticker_tick stores the current time into the cache.
+static void ticker_tick(void) {
+    int64_t nsec = time_to_unix_nano(time_now());
+    atomic_store_explicit(&cached_nsec, nsec != 0 ? nsec : 1, memory_order_release);
+}
+
+// ticker_sleep pauses the ticker thread for the given duration.
+static void ticker_sleep(Duration d) {
+#if defined(_WIN32)
+    DWORD msec = (DWORD)(d / TIME_MILLI);
+    Sleep(msec > 0 ? msec : 1);
+#else
+    struct timespec ts = {(time_t)(d / TIME_SECOND), (long)(d % TIME_SECOND)};
+    nanosleep(&ts, NULL);
+#endif
+}
+
+// ticker_loop refreshes the cache until the ticker is stopped.
+static void ticker_loop(void) {
+    while (atomic_load_explicit(&ticker_state, memory_order_acquire) != TICKER_STOPPING) {
+        ticker_sleep(ticker_interval);
+        ticker_tick();
+    }
+}
+
+#if defined(_WIN32)
+static HANDLE ticker_thread;
+
+static DWORD WINAPI ticker_main(LPVOID arg) {
+    (void)arg;
+    ticker_loop();
+    return 0;
+}
+
+// ticker_spawn starts the ticker thread.
+static bool ticker_spawn(void) {
+    ticker_thread = CreateThread(NULL, 0, ticker_main, NULL, 0, NULL);
+    return ticker_thread != NULL;
+}
+
+// ticker_join waits for the ticker thread to exit.
+static void ticker_join(void) {
+    WaitForSingleObject(ticker_thread, INFINITE);
+    CloseHandle(ticker_thread);
+}
+#else
+static pthread_t ticker_thread;
+
+static void* ticker_main(void* arg) {
+    (void)arg;
+    ticker_loop();
+    return NULL;
+}
+
+// ticker_spawn starts the ticker thread.
+static bool ticker_spawn(void) {
+    return pthread_create(&ticker_thread, NULL, ticker_main, NULL) == 0;
+}
+
+// ticker_join waits for the ticker thread to exit.
+static void ticker_join(void) {
+    pthread_join(ticker_thread, NULL);
+}
+#endif
+
+// time_clock_start starts a background thread that refreshes the
+// cached clock every interval (1 ms if interval is not positive).
+// Returns true if the cached clock is running, false if it is
+// not supported on this platform or the thread could not be started.
+// Calling time_clock_start while the clock is running does nothing.
+// Safe to call from any thread: if another thread is starting or stopping
+// the clock, waits for it to finish first.
+bool time_clock_start(Duration interval) {
+    for (;;) {
+        int state = TICKER_STOPPED;
+        if (atomic_compare_exchange_strong(&ticker_state, &state, TICKER_STARTING)) {
+            break;
+        }
+        if (state == TICKER_RUNNING) {
+            return true;
+        }
+        ticker_sleep(ticker_settle_wait);
+    }
+    ticker_interval = interval > 0 ? interval : TIME_MILLI;
+    ticker_tick();
+    if (!ticker_spawn()) {
+        atomic_store(&cached_nsec, 0);
+        atomic_store(&ticker_state, TICKER_STOPPED);
+        return false;
+    }
+    atomic_store(&ticker_state, TICKER_RUNNING);
+    return true;
+}
+
+// time_clock_stop stops the cached clock and waits for the background
+// thread to exit. Does nothing if the clock is not running.
+// Safe to call from any thread: if another thread is starting or stopping
+// the clock, waits for it to finish first.
+void time_clock_stop(void) {
+    for (;;) {
+        int state = TICKER_RUNNING;
+        if (atomic_compare_exchange_strong(&ticker_state, &state, TICKER_STOPPING)) {
+            break;
+        }
+        if (state == TICKER_STOPPED) {
+            return;
+        }
+        ticker_sleep(ticker_settle_wait);
+    }
+    ticker_join();
+    atomic_store(&cached_nsec, 0);
+    atomic_store(&ticker_state, TICKER_STOPPED);
+}
+
+// time_now_cached returns the time of the latest cached clock tick,
+// which lags behind the current time by at most the tick interval.
+// Falls back to time_now if the cached clock is not running.
+Time time_now_cached(void) {
+    int64_t nsec = atomic_load_explicit(&cached_nsec, memory_order_acquire);
+    if (nsec == 0) {
+        return time_now();
+    }
+    return time_unix(nsec / TIME_SECOND, nsec % TIME_SECOND);
+}
+
+#else
+
+bool time_clock_start(Duration interval) {
+    (void)interval;
+    return false;
+}
+
+void time_clock_stop(void) {}
+
+Time time_now_cached(void) {
+    return time_now();
+}
+
+#endif  // HAS_CACHED_CLOCK
+
+// ## Monotonic clock
+
+// time_mono_now returns the current reading of the monotonic clock.
+// Unlike time_now, the monotonic clock is not affected by changes
+// to the system wall clock, so it is suited for measuring elapsed time.
+// Falls back to the wall clock on platforms without a monotonic clock.
+MonoTime time_mono_now(void) {
+#if defined(_WIN32)
+    static LARGE_INTEGER freq;
+    if (freq.QuadPart == 0) {
+        QueryPerformanceFrequency(&freq);
+    }
+    LARGE_INTEGER count;
+    QueryPerformanceCounter(&count);
+    // Split the conversion to avoid overflowing count * 1e9.
+    int64_t sec = count.QuadPart / freq.QuadPart;
+    int64_t rem = count.QuadPart % freq.QuadPart;
+    return (MonoTime){sec * TIME_SECOND + rem * TIME_SECOND / freq.QuadPart};
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (MonoTime){(int64_t)ts.tv_sec * TIME_SECOND + ts.tv_nsec};
+#else
+    return (MonoTime){time_to_unix_nano(time_now())};
+#endif
+}
+
+// time_mono_add returns the monotonic reading t+d. If the result exceeds
+// the maximum (or minimum) reading, the maximum (or minimum) is returned.
+MonoTime time_mono_add(MonoTime t, Duration d) {
+    if (d > 0 && t.nsec > INT64_MAX - d) {
+        return (MonoTime){INT64_MAX};
+    }
+    if (d < 0 && t.nsec < INT64_MIN - d) {
+        return (MonoTime){INT64_MIN};
+    }
+    return (MonoTime){t.nsec + d};
+}
+
+// time_mono_sub returns the duration t-u. If the result exceeds the maximum
+// (or minimum) value that can be stored in a Duration, the maximum
+// (or minimum) duration will be returned.
+Duration time_mono_sub(MonoTime t, MonoTime u) {
+    if (u.nsec < 0 && t.nsec > DURATION_MAX + u.nsec) {
+        return DURATION_MAX;
+    }
+    if (u.nsec > 0 && t.nsec < DURATION_MIN + u.nsec) {
+        return DURATION_MIN;
+    }
+    return t.nsec - u.nsec;
+}
+
+// time_mono_since returns the time elapsed since t.
+// It is shorthand for time_mono_sub(time_mono_now(), t).
+Duration time_mono_since(MonoTime t) {
+    return time_mono_sub(time_mono_now(), t);
+}
+
+// time_mono_until returns the duration until t.
+// It is shorthand for time_mono_sub(t, time_mono_now()).
+Duration time_mono_until(MonoTime t) {
+    return time_mono_sub(t, time_mono_now());
+}
+
+// ## TSC clock
+
+#if HAS_TSC_CLOCK
+
+// tsc_calibration_time is how long time_tsc_init measures the TSC rate (10 ms).
+static const Duration tsc_calibration_time = 10000000;
+
+// tsc_recalibration_time is how often time_now_tsc re-anchors the TSC
+// to the wall clock and refines the TSC rate (1 s).
+static const Duration tsc_recalibration_time = 1000000000;
+
+// The TSC clock converts a TSC reading to Unix nanoseconds as
+// anchor_nsec + (tsc - anchor) * mult / 2^32. The fields are protected
+// by a sequence lock: the sequence number is odd while they are updated.
+static _Atomic uint32_t tsc_seq;
+static _Atomic uint64_t tsc_anchor;      // TSC reading at the anchor
+static _Atomic int64_t tsc_anchor_nsec;  // Unix nanoseconds at the anchor
+static _Atomic uint64_t tsc_mult;        // nanoseconds per tick, 32.32 fixed point
+static _Atomic uint64_t tsc_period;      // ticks between recalibrations, 0 if not initialized
+
+// tsc_lock serializes calibrations. The base fields are only accessed
+// while holding the lock and record the first calibration sample,
+// so that the rate is measured over an ever longer interval.
+static atomic_flag tsc_lock = ATOMIC_FLAG_INIT;
+static uint64_t tsc_base;
+static int64_t tsc_base_mono;
+
+// TscSample is a TSC reading taken together with the monotonic
+// and wall clocks.
+typedef struct {
+    uint64_t tsc;
+    int64_t mono;
+    int64_t wall;
+} TscSample;
+
+// tsc_read returns the current TSC value.
+static inline uint64_t tsc_read(void) {
+    return __rdtsc();
+}
+
+// tsc_invariant reports whether the CPU has an invariant TSC,
+// which ticks at a constant rate regardless of power states.
+static bool tsc_invariant(void) {
+#if defined(_MSC_VER)
+    int regs[4];
+    __cpuid(regs, (int)0x80000000);
+    if ((unsigned)regs[0] < 0x80000007u) {
+        return false;
+    }
+    __cpuid(regs, (int)0x80000007);
+    return (regs[3] & (1 << 8)) != 0;
+#else
+    unsigned eax, ebx, ecx, edx;
+    if (!__get_cpuid(0x80000007u, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    return (edx & (1u << 8)) != 0;
+#endif
+}
+
+// tsc_sample reads the clocks between two TSC readings and attributes
+// them to the midpoint. Keeps the tightest of several attempts.
+static TscSample tsc_sample(void) {
+    TscSample best = {0, 0, 0};
+    uint64_t best_width = UINT64_MAX;
+    for (int i = 0; i < 5; i++) {
+        uint64_t before = tsc_read();
+        int64_t mono = time_mono_now().nsec;
+        int64_t wall = time_to_unix_nano(time_now());
+        uint64_t after = tsc_read();
+        if (after - before < best_width) {
+            best_width = after - before;
+            best = (TscSample){before + (after - before) / 2, mono, wall};
+        }
+    }
+    return best;
+}
+
+// tsc_scale converts a number of ticks to nanoseconds.
+// Splits the multiplication so that it does not overflow 64 bits.
+static inline uint64_t tsc_scale(uint64_t ticks, uint64_t mult) {
+    return (ticks >> 32) * mult + (((ticks & 0xFFFFFFFF) * mult) >> 32);
+}
+
+// tsc_publish anchors the TSC clock at the given sample
+// with the given rate in nanoseconds per tick.
+static void tsc_publish(TscSample s, double rate) {
+    uint32_t seq = atomic_load_explicit(&tsc_seq, memory_order_relaxed);
+    atomic_store_explicit(&tsc_seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&tsc_anchor, s.tsc, memory_order_relaxed);
+    atomic_store_explicit(&tsc_anchor_nsec, s.wall, memory_order_relaxed);
+    atomic_store_explicit(&tsc_mult, (uint64_t)(rate * 4294967296.0), memory_order_relaxed);
+    atomic_store_explicit(&tsc_period, (uint64_t)((double)tsc_recalibration_time / rate),
+                          memory_order_relaxed);
+    atomic_store_explicit(&tsc_seq, seq + 2, memory_order_release);
+}
+
+// tsc_recalibrate re-anchors the TSC clock at the current time and
+// measures the rate since the first calibration. Must hold tsc_lock.
+static void tsc_recalibrate(void) {
+    TscSample s = tsc_sample();
+    double rate = (double)(s.mono - tsc_base_mono) / (double)(s.tsc - tsc_base);
+    tsc_publish(s, rate);
+}
+
+// time_tsc_init calibrates the TSC clock against the system clocks,
+// which takes about 10 ms. Returns false if the CPU lacks an invariant
+// TSC, in which case time_now_tsc falls back to time_now.
+// Calling time_tsc_init after a successful calibration does nothing.
+bool time_tsc_init(void) {
+    if (atomic_load(&tsc_period) != 0) {
+        return true;
+    }
+    if (!tsc_invariant()) {
+        return false;
+    }
+    while (atomic_flag_test_and_set_explicit(&tsc_lock, memory_order_acquire)) {
+    }
+    if (atomic_load(&tsc_period) == 0) {
+        TscSample start = tsc_sample();
+        TscSample end = start;
+        while (end.mono - start.mono < tsc_calibration_time) {
+            end = tsc_sample();
+        }
+        tsc_base = start.tsc;
+        tsc_base_mono = start.mono;
+        double rate = (double)(end.mono - start.mono) / (double)(end.tsc - start.tsc);
+        tsc_publish(end, rate);
+    }
+    atomic_flag_clear_explicit(&tsc_lock, memory_order_release);
+    return true;
+}
+
+// time_now_tsc returns the current time in UTC computed from the CPU
+// time stamp counter. Requires a prior call to time_tsc_init,
+// and falls back to time_now if it has not succeeded.
+Time time_now_tsc(void) {
+    uint64_t tsc = tsc_read();
+    for (;;) {
+        uint32_t seq = atomic_load_explicit(&tsc_seq, memory_order_acquire);
+        if (seq & 1) {
+            continue;
+        }
+        uint64_t anchor = atomic_load_explicit(&tsc_anchor, memory_order_relaxed);
+        int64_t nsec = atomic_load_explicit(&tsc_anchor_nsec, memory_order_relaxed);
+        uint64_t mult = atomic_load_explicit(&tsc_mult, memory_order_relaxed);
+        uint64_t period = atomic_load_explicit(&tsc_period, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&tsc_seq, memory_order_relaxed) != seq) {
+            continue;
+        }
+        if (period == 0) {
+            return time_now();
+        }
+
+        // Another thread may have re-anchored the clock after tsc was read.
+        if (tsc < anchor) {
+            nsec -= (int64_t)tsc_scale(anchor - tsc, mult);
+            return time_unix_nano(nsec);
+        }
+
+        uint64_t ticks = tsc - anchor;
+        if (ticks >= period &&
+            !atomic_flag_test_and_set_explicit(&tsc_lock, memory_order_acquire)) {
+            tsc_recalibrate();
+            atomic_flag_clear_explicit(&tsc_lock, memory_order_release);
+            tsc = tsc_read();
+            continue;
+        }
+        nsec += (int64_t)tsc_scale(ticks, mult);
+        return time_unix_nano(nsec);
+    }
+}
+
+#else
+
+bool time_tsc_init(void) {
+    return false;
+}
+
+Time time_now_tsc(void) {
+    return time_now();
+}
+
+#endif  // HAS_TSC_CLOCK
@@ -0,0 +1,346 @@
+// Copyright 2025 Anton Zhiyanov, BSD 3-Clause License
+// https://github.com/nalgeon/vaqt
+
+// Time column compression.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "vaqt.h"
+
+// ## Delta-of-delta
+
+// Each time value is encoded relative to the previous one as a pair:
+// - the delta-of-delta of seconds (the change in the gap between values),
+// - the delta of nanoseconds.
+// Both are zigzag-encoded, so that small negative values stay small,
+// and written as LEB128 varints. The first byte of a value carries
+// a flag telling whether the nanoseconds delta follows, so a value
+// with a regular gap and unchanged nanoseconds takes a single byte:
+//
+//   first byte: [continuation:1][dod bits 0-5:6][has nsec:1]
+//   then: dod bits 6-63 as a varint, if the continuation bit is set
+//   then: nsec delta as a varint, if the nsec flag is set
+//
+// All arithmetic on seconds wraps around modulo 2^64,
+// so any sequence of time values round-trips exactly.
+
+// zigzag maps signed values to unsigned ones: 0, -1, 1, -2, 2... to 0, 1, 2, 3, 4...
+static inline uint64_t zigzag(uint64_t v) {
+    return (v << 1) ^ (0 - (v >> 63));
+}
+
+// unzigzag is the inverse of zigzag.
+static inline uint64_t unzigzag(uint64_t v) {
+    return (v >> 1) ^ (0 - (v & 1));
+}
+
+// put_varint writes v at buf as a LEB128 varint,
+// and returns the number of bytes written.
+static inline size_t put_varint(uint8_t* buf, uint64_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        buf[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    buf[n++] = (uint8_t)v;
+    return n;
+}
+
+// get_varint reads a LEB128 varint of at most max bytes at buf[*r], reading
+// at most len bytes in total. Reports whether the varint is well-formed.
+static inline bool get_varint(const uint8_t* buf, size_t len, size_t* r, int max, uint64_t* v) {
+    uint64_t x = 0;
+    for (int i = 0, shift = 0; i < max && *r < len; i++, shift += 7) {
+        uint8_t b = buf[(*r)++];
+        x |= (uint64_t)(b & 0x7f) << shift;
+        if (b < 0x80) {
+            *v = x;
+            return true;
+        }
+    }
+    return false;  // truncated or too long
+}
+
+// put_dod_value writes a value with the zigzagged delta-of-delta of seconds zz
+// and the zigzagged delta of nanoseconds zzn, and returns the number of bytes written.
+static inline size_t put_dod_value(uint8_t* buf, uint64_t zz, uint64_t zzn) {
+    uint8_t flag = zzn != 0;
+    size_t n = 1;
+    if (zz < 64) {
+        buf[0] = (uint8_t)(zz << 1 | flag);
+    } else {
+        buf[0] = (uint8_t)(0x80 | (zz & 0x3f) << 1 | flag);
+        n += put_varint(buf + 1, zz >> 6);
+    }
+    if (flag) {
+        n += put_varint(buf + n, zzn);
+    }
+    return n;
+}
+
+// time_dod_encode compresses n time values using delta-of-delta encoding,
+// writing at most size bytes to buf. Each value takes at most TIME_DOD_MAX_SIZE
+// bytes, and a regular series (a constant gap in seconds and constant
+// nanoseconds, like a metric scraped every 10 seconds) takes one byte per value.
+// Works best for sorted or nearly sorted values, but accepts any values.
+//
+// The state carries the last encoded value between calls, so a long series
+// can be encoded in chunks: the output of consecutive calls forms one stream.
+// A zero state starts a new stream.
+//
+// Returns the number of bytes written. If buf is too small, leaves
+// the state unchanged and returns 0. For n == 0, writes nothing and
+// returns 0, which is not an error.
+size_t time_dod_encode(TimeDodState* state, const Time* in, size_t n, uint8_t* buf, size_t size) {
+    TimeDodState st = *state;
+    size_t w = 0;
+    for (size_t i = 0; i < n; i++) {
+        Time t = in[i];
+        uint64_t delta = (uint64_t)t.sec - (uint64_t)st.sec;
+        uint64_t zz = zigzag(delta - (uint64_t)st.delta);
+        uint64_t zzn = zigzag((uint64_t)((int64_t)t.nsec - st.nsec));
+        if (size - w >= TIME_DOD_MAX_SIZE) {
+            w += put_dod_value(buf + w, zz, zzn);
+        } else {
+            // Near the end of the buffer, check that the value fits.
+            uint8_t tmp[TIME_DOD_MAX_SIZE];
+            size_t k = put_dod_value(tmp, zz, zzn);
+            if (k > size - w) {
+                return 0;
+            }
+            memcpy(buf + w, tmp, k);
+            w += k;
+        }
+        st.sec = t.sec;
+        st.delta = (int64_t)delta;
+        st.nsec = t.nsec;
+    }
+    *state = st;
+    return w;
+}
+
+// time_dod_decode decompresses n time values encoded by time_dod_encode,
+// reading at most len bytes from buf. The state must be the same as the one
+// the encoder had when it wrote buf (a zero state for a new stream).
+//
+// Returns the number of bytes consumed. If the data is truncated or malformed,
+// leaves the state unchanged and returns 0 (out may be partially written).
+// For n == 0, reads nothing and returns 0, which is not an error.
+size_t time_dod_decode(TimeDodState* state, const uint8_t* buf, size_t len, Time* out, size_t n) {
+    TimeDodState st = *state;
+    size_t r = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (r == len) {
+            return 0;  // truncated
+        }
+        uint8_t b = buf[r++];
+        uint64_t zz = (uint64_t)(b >> 1 & 0x3f);
+        if (b & 0x80) {
+            uint64_t hi;
+            if (!get_varint(buf, len, &r, 9, &hi) || hi >> 58 != 0) {
+                return 0;  // truncated or wider than 64 bits
+            }
+            zz |= hi << 6;
+        }
+        int64_t nsec = st.nsec;
+        if (b & 1) {
+            uint64_t zzn;
+            if (!get_varint(buf, len, &r, 5, &zzn)) {
+                return 0;
+            }
+            nsec += (int64_t)unzigzag(zzn);
+            if (nsec < 0 || nsec > 999999999) {
+                return 0;  // malformed
+            }
+        }
+        uint64_t delta = (uint64_t)st.delta + unzigzag(zz);
+        st.sec = (int64_t)((uint64_t)st.sec + delta);
+        st.delta = (int64_t)delta;
+        st.nsec = (int32_t)nsec;
+        out[i] = (Time){st.sec, st.nsec};
+    }
+    *state = st;
+    return r;
+}
+
+// ## Frame of reference
+
+// A frame-of-reference block stores the smallest value (the base) and,
+// for each value, its offset from the base in nanoseconds, bit-packed
+// with a fixed width. Fixed width makes any value accessible in O(1).
+//
+//   0-7: base seconds, little-endian
+//   8-11: base nanoseconds, little-endian
+//   12-15: number of values, little-endian
+//   16: bits per offset (0-63)
+//   17...: offsets, bit-packed little-endian (value i at bits i*width...)
+//   then: 8 zero bytes of padding, so that a 64-bit load at any value stays in bounds
+
+// for_max_span is the largest span of a block in seconds. It keeps offsets
+// from the base within a Duration.
+static const uint64_t for_max_span = 9223372035;
+
+// store_le writes the low n bytes of v at b in little-endian byte order.
+static inline void store_le(uint8_t* b, uint64_t v, size_t n) {
+    for (size_t i = 0; i < n; i++, v >>= 8) {
+        b[i] = (uint8_t)v;
+    }
+}
+
+// load_le64 reads a little-endian 64-bit value at b.
+// Compilers turn this into a single load on little-endian targets.
+static inline uint64_t load_le64(const uint8_t* b) {
+    return (uint64_t)b[0] | (uint64_t)b[1] << 8 | (uint64_t)b[2] << 16 | (uint64_t)b[3] << 24 |
+           (uint64_t)b[4] << 32 | (uint64_t)b[5] << 40 | (uint64_t)b[6] << 48 |
+           (uint64_t)b[7] << 56;
+}
+
+// load_le32 reads a little-endian 32-bit value at b.
+static inline uint32_t load_le32(const uint8_t* b) {
+    return (uint32_t)b[0] | (uint32_t)b[1] << 8 | (uint32_t)b[2] << 16 | (uint32_t)b[3] << 24;
+}
+
+// for_unpack returns the offset of value k in bit-packed data of the given width.
+static inline uint64_t for_unpack(const uint8_t* data, unsigned width, size_t k) {
+    uint64_t bit = (uint64_t)k * width;
+    const uint8_t* p = data + (bit >> 3);
+    unsigned shift = (unsigned)(bit & 7);
+    uint64_t x = load_le64(p) >> shift;
+    if (shift + width > 64) {
+        // The value straddles the 64-bit word.
+        x |= (uint64_t)p[8] << (64 - shift);
+    }
+    return x & (((uint64_t)1 << width) - 1);
+}
+
+// for_sub returns t-base in nanoseconds for t not before base and less than
+// for_max_span seconds after it. Same as time_sub, but without the overflow
+// checks, which time_for_encode does once for the whole block.
+static inline uint64_t for_sub(Time t, Time base) {
+    return ((uint64_t)t.sec - (uint64_t)base.sec) * 1000000000 + (uint64_t)t.nsec -
+           (uint64_t)base.nsec;
+}
+
+// for_add returns base+d for a non-negative d. Same as time_add,
+// but with a constant divisor, which compiles to a multiplication.
+// The seconds are added as unsigned, so a malformed block with a base
+// too close to the maximum time wraps around instead of overflowing.
+static inline Time for_add(Time base, uint64_t d) {
+    uint64_t nsec = (uint64_t)base.nsec + d % 1000000000;
+    uint64_t sec = (uint64_t)base.sec + d / 1000000000;
+    if (nsec >= 1000000000) {
+        sec++;
+        nsec -= 1000000000;
+    }
+    return (Time){(int64_t)sec, (int32_t)nsec};
+}
+
+// time_for_encode compresses n time values into a frame-of-reference block:
+// the smallest value, followed by the offset of each value from it in
+// nanoseconds, bit-packed with just enough bits for the largest offset.
+// Values may come in any order. Unlike time_dod_encode, the block supports
+// O(1) access to any value (see time_for_open and time_for_get).
+//
+// Writes at most size bytes to buf. A buffer of TIME_FOR_HEADER_SIZE + 8 * (n + 1)
+// bytes always fits. Returns the number of bytes written. Returns 0 if buf is
+// too small, if n exceeds UINT32_MAX, or if the seconds of the values are more
+// than 9223372035 apart (about 292 years, so offsets fit in a Duration).
+size_t time_for_encode(const Time* in, size_t n, uint8_t* buf, size_t size) {
+    if ((uint64_t)n > UINT32_MAX) {
+        return 0;
+    }
+
+    // Find the base and the span.
+    Time base = n > 0 ? in[0] : (Time){0, 0};
+    Time max = base;
+    for (size_t i = 1; i < n; i++) {
+        if (time_before(in[i], base)) {
+            base = in[i];
+        }
+        if (time_after(in[i], max)) {
+            max = in[i];
+        }
+    }
+    if ((uint64_t)max.sec - (uint64_t)base.sec > for_max_span) {
+        return 0;
+    }
+    uint64_t span = for_sub(max, base);
+    unsigned width = 0;
+    while (width < 64 && span >> width != 0) {
+        width++;
+    }
+
+    size_t data_len = (size_t)(((uint64_t)n * width + 7) / 8);
+    size_t total = TIME_FOR_HEADER_SIZE + data_len + 8;
+    if (size < total) {
+        return 0;
+    }
+
+    store_le(buf, (uint64_t)base.sec, 8);
+    store_le(buf + 8, (uint32_t)base.nsec, 4);
+    store_le(buf + 12, (uint32_t)n, 4);
+    buf[16] = (uint8_t)width;
+
+    // Accumulate offsets into 64-bit words, flushing each full word.
+    uint8_t* data = buf + TIME_FOR_HEADER_SIZE;
+    uint64_t acc = 0;
+    unsigned fill = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t off = for_sub(in[i], base);
+        acc |= off << fill;
+        if (fill + width >= 64) {
+            store_le(data, acc, 8);
+            data += 8;
+            // fill > 0 here, since width < 64.
+            acc = off >> (64 - fill);
+            fill = fill + width - 64;
+        } else {
+            fill += width;
+        }
+    }
+    store_le(data, acc, (fill + 7) / 8);
+    memset(buf + TIME_FOR_HEADER_SIZE + data_len, 0, 8);
+    return total;
+}
+
+// time_for_open checks the frame-of-reference block of len bytes at buf
+// and fills in *block for use with time_for_get and time_for_decode.
+// The block refers to buf, so buf must outlive it.
+// Returns false if the block is truncated or malformed. The offsets themselves
+// are not checked, so a corrupted block may yield wrong (but valid) times.
+bool time_for_open(const uint8_t* buf, size_t len, TimeForBlock* block) {
+    if (len < TIME_FOR_HEADER_SIZE + 8) {
+        return false;
+    }
+    Time base = {(int64_t)load_le64(buf), (int32_t)load_le32(buf + 8)};
+    uint32_t n = load_le32(buf + 12);
+    unsigned width = buf[16];
+    if (base.nsec < 0 || base.nsec > 999999999 || width > 63) {
+        return false;
+    }
+    uint64_t data_len = ((uint64_t)n * width + 7) / 8;
+    if (data_len > len - TIME_FOR_HEADER_SIZE - 8) {
+        return false;
+    }
+    *block = (TimeForBlock){base, buf + TIME_FOR_HEADER_SIZE, n, (uint8_t)width};
+    return true;
+}
+
+// time_for_get returns value k of the block. Takes constant time
+// regardless of k. k must be less than the number of values in the block.
+Time time_for_get(const TimeForBlock* block, size_t k) {
+    return for_add(block->base, for_unpack(block->data, block->width, k));
+}
+
+// time_for_decode decompresses all values of the block into out,
+// which must have room for block->n values.
+void time_for_decode(const TimeForBlock* block, Time* out) {
+    Time base = block->base;
+    const uint8_t* data = block->data;
+    unsigned width = block->width;
+    for (size_t i = 0; i < block->n; i++) {
+        out[i] = for_add(base, for_unpack(data, width, i));
+    }
+}
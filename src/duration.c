@@ -6,8 +6,10 @@
 
 // Duration methods.
 
+#include <limits.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 #include <time.h>
 
 #include "vaqt.h"
@@ -112,3 +114,531 @@ Duration duration_abs(Duration d) {
     }
     return d < 0 ? -d : d;
 }
+
+// ## Formatting
+
+// DURATION_BUF_SIZE fits the longest duration string,
+// -2562047h47m16.854775808s (25 characters).
+#define DURATION_BUF_SIZE 32
+
+// fmt_frac formats the fraction of v/10^prec (e.g., ".12345") into the tail
+// of buf ending at w, omitting trailing zeros. Omits the decimal point when
+// the fraction is 0. Returns the new start of the string and v/10^prec.
+static size_t fmt_frac(char* buf, size_t w, uint64_t* v, int prec) {
+    bool print = false;
+    for (int i = 0; i < prec; i++) {
+        unsigned digit = (unsigned)(*v % 10);
+        print = print || digit != 0;
+        if (print) {
+            buf[--w] = (char)('0' + digit);
+        }
+        *v /= 10;
+    }
+    if (print) {
+        buf[--w] = '.';
+    }
+    return w;
+}
+
+// fmt_uint formats v into the tail of buf ending at w,
+// and returns the new start of the string.
+static size_t fmt_uint(char* buf, size_t w, uint64_t v) {
+    do {
+        buf[--w] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v > 0);
+    return w;
+}
+
+// fmt_copy copies the string s of n bytes into buf like snprintf does:
+// writes at most size-1 characters followed by a NUL terminator.
+// Returns n.
+static size_t fmt_copy(const char* s, size_t n, char* buf, size_t size) {
+    if (size > 0) {
+        size_t m = n < size ? n : size - 1;
+        memcpy(buf, s, m);
+        buf[m] = '\0';
+    }
+    return n;
+}
+
+// duration_fmt returns a string representing the duration in the form "72h3m0.5s".
+// Leading zero units are omitted. As a special case, durations less than one
+// second use a smaller unit (milli-, micro-, or nanoseconds) to ensure
+// that the leading digit is non-zero. The zero duration formats as 0s.
+// Like Go, writes the microsecond unit as "µs" (U+00B5, two bytes in UTF-8).
+// Like snprintf, writes at most size-1 characters followed by a NUL terminator,
+// and returns the length of the full string.
+size_t duration_fmt(Duration d, char* buf, size_t size) {
+    // Writes the string backwards from the end of tmp.
+    char tmp[DURATION_BUF_SIZE];
+    size_t w = sizeof(tmp);
+    uint64_t u = (uint64_t)d;
+    bool neg = d < 0;
+    if (neg) {
+        u = -u;
+    }
+
+    if (u < (uint64_t)TIME_SECOND) {
+        // Special case: if duration is smaller than a second,
+        // use smaller units, like 1.2ms.
+        int prec = 0;
+        tmp[--w] = 's';
+        if (u == 0) {
+            tmp[--w] = '0';
+        } else {
+            if (u < (uint64_t)TIME_MICRO) {
+                prec = 0;
+                tmp[--w] = 'n';
+            } else if (u < (uint64_t)TIME_MILLI) {
+                prec = 3;
+                tmp[--w] = '\xb5';  // U+00B5 'µ' micro sign == 0xC2 0xB5
+                tmp[--w] = '\xc2';
+            } else {
+                prec = 6;
+                tmp[--w] = 'm';
+            }
+            w = fmt_frac(tmp, w, &u, prec);
+            w = fmt_uint(tmp, w, u);
+        }
+    } else {
+        tmp[--w] = 's';
+        w = fmt_frac(tmp, w, &u, 9);
+
+        // u is now integer seconds.
+        w = fmt_uint(tmp, w, u % 60);
+        u /= 60;
+
+        // u is now integer minutes.
+        if (u > 0) {
+            tmp[--w] = 'm';
+            w = fmt_uint(tmp, w, u % 60);
+            u /= 60;
+
+            // u is now integer hours.
+            // Stop at hours because days can be different lengths.
+            if (u > 0) {
+                tmp[--w] = 'h';
+                w = fmt_uint(tmp, w, u);
+            }
+        }
+    }
+
+    if (neg) {
+        tmp[--w] = '-';
+    }
+
+    return fmt_copy(tmp + w, sizeof(tmp) - w, buf, size);
+}
+
+// ## Parsing
+
+// duration_maxabs is the largest absolute value of a duration (that of DURATION_MIN).
+static const uint64_t duration_maxabs = (uint64_t)1 << 63;
+
+// is_digit reports whether c is a decimal digit.
+static inline bool is_digit(char c) {
+    return (unsigned)((unsigned char)c - '0') <= 9u;
+}
+
+// is_unit_char reports whether c can be part of a unit name:
+// an ASCII letter or a byte of a multi-byte UTF-8 sequence (as in "µs").
+static inline bool is_unit_char(char c) {
+    unsigned char u = (unsigned char)c;
+    return (unsigned)((u | 0x20) - 'a') < 26u || u >= 0x80;
+}
+
+// parse_uint consumes the decimal digits starting at s[*i], reading at most
+// len bytes, and returns their value. Saturates to duration_maxabs+1 on overflow.
+static uint64_t parse_uint(const char* s, size_t len, size_t* i) {
+    uint64_t v = 0;
+    for (; *i < len && is_digit(s[*i]); (*i)++) {
+        if (v > duration_maxabs / 10) {
+            v = duration_maxabs + 1;
+            continue;
+        }
+        v = v * 10 + (uint64_t)(s[*i] - '0');
+        if (v > duration_maxabs) {
+            v = duration_maxabs + 1;
+        }
+    }
+    return v;
+}
+
+// scale_decimal returns the number v.frac (frac being n fraction digits)
+// multiplied by unit, truncated to an integer. Saturates to duration_maxabs+1
+// on overflow. Uses exact integer arithmetic: multiplies the fraction by
+// the unit digit by digit, starting from the last one. The carry out of
+// the first digit is the integer part of the product, and it never exceeds the unit.
+static uint64_t scale_decimal(uint64_t v, const char* frac, size_t n, uint64_t unit) {
+    if (v > duration_maxabs / unit) {
+        return duration_maxabs + 1;
+    }
+    uint64_t carry = 0;
+    for (size_t j = n; j > 0; j--) {
+        carry = (unit * (uint64_t)(frac[j - 1] - '0') + carry) / 10;
+    }
+    v = v * unit + carry;
+    return v > duration_maxabs ? duration_maxabs + 1 : v;
+}
+
+// parse_unit looks up the unit of n bytes at s, and stores its length
+// in nanoseconds in *unit. Reports whether the unit is known.
+static bool parse_unit(const char* s, size_t n, uint64_t* unit) {
+    switch (n) {
+        case 1:
+            switch (s[0]) {
+                case 's':
+                    *unit = (uint64_t)TIME_SECOND;
+                    return true;
+                case 'm':
+                    *unit = (uint64_t)TIME_MINUTE;
+                    return true;
+                case 'h':
+                    *unit = (uint64_t)TIME_HOUR;
+                    return true;
+            }
+            return false;
+        case 2:
+            if (s[1] != 's') {
+                return false;
+            }
+            switch (s[0]) {
+                case 'n':
+                    *unit = (uint64_t)TIME_NANO;
+                    return true;
+                case 'u':
+                    *unit = (uint64_t)TIME_MICRO;
+                    return true;
+                case 'm':
+                    *unit = (uint64_t)TIME_MILLI;
+                    return true;
+            }
+            return false;
+        case 3:
+            // U+00B5 'µ' micro sign and U+03BC 'μ' Greek letter mu.
+            if (memcmp(s, "\xc2\xb5s", 3) == 0 || memcmp(s, "\xce\xbcs", 3) == 0) {
+                *unit = (uint64_t)TIME_MICRO;
+                return true;
+            }
+            return false;
+    }
+    return false;
+}
+
+// duration_parse parses a duration string at the beginning of s, reading at most len bytes.
+// A duration string is a possibly signed sequence of decimal numbers, each with
+// optional fraction and a unit suffix, such as "300ms", "-1.5h" or "2h45m".
+// Valid time units are "ns", "us" (or "µs"), "ms", "s", "m", "h".
+// As a special case, a bare "0" means the zero duration.
+// Uses exact integer arithmetic, so fractions are truncated to the nanosecond
+// rather than rounded through a floating-point value.
+// On success, stores the duration in *out and returns the number of bytes consumed.
+// On failure (invalid syntax, unknown unit or overflow), leaves *out unchanged and returns 0.
+size_t duration_parse(const char* s, size_t len, Duration* out) {
+    size_t i = 0;
+    bool neg = false;
+
+    // Consume [-+]?
+    if (i < len && (s[i] == '-' || s[i] == '+')) {
+        neg = s[i] == '-';
+        i++;
+    }
+
+    // Special case: a bare "0" does not need a unit.
+    if (i < len && s[i] == '0' &&
+        (i + 1 == len || !(is_digit(s[i + 1]) || s[i + 1] == '.' || is_unit_char(s[i + 1])))) {
+        *out = 0;
+        return i + 1;
+    }
+
+    // The first number must start with [0-9.].
+    if (i == len || !(is_digit(s[i]) || s[i] == '.')) {
+        return 0;
+    }
+
+    uint64_t d = 0;
+    while (i < len && (is_digit(s[i]) || s[i] == '.')) {
+        // Consume [0-9]*
+        size_t start = i;
+        uint64_t v = parse_uint(s, len, &i);
+        if (v > duration_maxabs) {
+            return 0;  // overflow
+        }
+        bool pre = i != start;
+
+        // Consume (\.[0-9]*)?
+        size_t frac_start = i, frac_end = i;
+        if (i < len && s[i] == '.') {
+            i++;
+            frac_start = i;
+            while (i < len && is_digit(s[i])) {
+                i++;
+            }
+            frac_end = i;
+        }
+        bool post = frac_end != frac_start;
+        if (!pre && !post) {
+            return 0;  // no digits (e.g. ".s" or "-.s")
+        }
+
+        // Consume unit.
+        size_t unit_start = i;
+        while (i < len && is_unit_char(s[i])) {
+            i++;
+        }
+        uint64_t unit;
+        if (!parse_unit(s + unit_start, i - unit_start, &unit)) {
+            return 0;  // missing or unknown unit
+        }
+
+        v = scale_decimal(v, s + frac_start, frac_end - frac_start, unit);
+        if (v > duration_maxabs) {
+            return 0;  // overflow
+        }
+
+        d += v;
+        if (d > duration_maxabs) {
+            return 0;  // overflow
+        }
+    }
+
+    if (neg) {
+        *out = d == duration_maxabs ? DURATION_MIN : -(Duration)d;
+    } else {
+        if (d > (uint64_t)DURATION_MAX) {
+            return 0;  // overflow
+        }
+        *out = (Duration)d;
+    }
+    return i;
+}
+
+// ## ISO 8601 durations
+
+// PERIOD_BUF_SIZE fits the longest ISO 8601 duration string,
+// P-2147483648Y-2147483648M-2147483648DT-2562047H-47M-16.854775808S (65 characters).
+#define PERIOD_BUF_SIZE 80
+
+// put_uint formats v into buf starting at w, and returns the new end of the string.
+static size_t put_uint(char* buf, size_t w, uint64_t v) {
+    char digits[24];
+    size_t start = fmt_uint(digits, sizeof(digits), v);
+    size_t n = sizeof(digits) - start;
+    memcpy(buf + w, digits + start, n);
+    return w + n;
+}
+
+// period_fmt returns an ISO 8601 duration string such as "P1Y2M3DT4H5M6.5S".
+// Zero components are omitted, and the zero period formats as PT0S.
+// The exact part is written as hours, minutes and seconds (never days),
+// with the fraction of a second omitting trailing zeros.
+// When no component is positive, writes a single leading minus sign
+// ("-P1DT2H"). Otherwise, writes a minus sign before each negative
+// component ("P1DT-2H").
+// Like snprintf, writes at most size-1 characters followed by a NUL terminator,
+// and returns the length of the full string.
+size_t period_fmt(Period p, char* buf, size_t size) {
+    char tmp[PERIOD_BUF_SIZE];
+    size_t w = 0;
+
+    static const char date_units[] = "YMD";
+    int64_t date[3] = {p.years, p.months, p.days};
+    bool zero = date[0] == 0 && date[1] == 0 && date[2] == 0 && p.duration == 0;
+    bool neg = !zero && date[0] <= 0 && date[1] <= 0 && date[2] <= 0 && p.duration <= 0;
+    if (neg) {
+        tmp[w++] = '-';
+    }
+    tmp[w++] = 'P';
+
+    for (int k = 0; k < 3; k++) {
+        if (date[k] == 0) {
+            continue;
+        }
+        int64_t v = neg ? -date[k] : date[k];
+        if (v < 0) {
+            tmp[w++] = '-';
+            v = -v;
+        }
+        w = put_uint(tmp, w, (uint64_t)v);
+        tmp[w++] = date_units[k];
+    }
+
+    if (p.duration == 0 && !zero) {
+        return fmt_copy(tmp, w, buf, size);
+    }
+
+    tmp[w++] = 'T';
+    uint64_t u = (uint64_t)p.duration;
+    if (p.duration < 0) {
+        u = -u;
+    }
+    bool dneg = p.duration < 0 && !neg;
+    uint64_t hours = u / (uint64_t)TIME_HOUR;
+    uint64_t mins = u / (uint64_t)TIME_MINUTE % 60;
+    uint64_t nsec = u % (uint64_t)TIME_MINUTE;
+    if (hours > 0) {
+        if (dneg) {
+            tmp[w++] = '-';
+        }
+        w = put_uint(tmp, w, hours);
+        tmp[w++] = 'H';
+    }
+    if (mins > 0) {
+        if (dneg) {
+            tmp[w++] = '-';
+        }
+        w = put_uint(tmp, w, mins);
+        tmp[w++] = 'M';
+    }
+    if (nsec > 0 || u == 0) {
+        if (dneg) {
+            tmp[w++] = '-';
+        }
+        // Seconds with fraction, written backwards.
+        char secs[24];
+        size_t start = sizeof(secs);
+        secs[--start] = 'S';
+        start = fmt_frac(secs, start, &nsec, 9);
+        start = fmt_uint(secs, start, nsec);
+        memcpy(tmp + w, secs + start, sizeof(secs) - start);
+        w += sizeof(secs) - start;
+    }
+    return fmt_copy(tmp, w, buf, size);
+}
+
+// parse_sign consumes an optional sign at s[*i] and reports whether it is a minus.
+static bool parse_sign(const char* s, size_t len, size_t* i) {
+    if (*i < len && (s[*i] == '-' || s[*i] == '+')) {
+        return s[(*i)++] == '-';
+    }
+    return false;
+}
+
+// period_parse parses an ISO 8601 duration string at the beginning of s,
+// reading at most len bytes. The format is [-]PnYnMnWnDTnHnMnS, where
+// components with zero values may be omitted, but at least one must be present.
+// Weeks (W) are converted to days. Only the last component may have a fraction
+// (with either a point or a comma), and only if it is hours, minutes or seconds:
+// the calendar components are not of fixed length. Designators must be uppercase.
+//
+// As an extension, any component may have its own sign, as in "P1MT-1H".
+// A leading minus sign negates all components. This accepts everything
+// period_fmt produces.
+//
+// On success, stores the period in *out and returns the number of bytes consumed.
+// On failure (invalid syntax or overflow), leaves *out unchanged and returns 0.
+size_t period_parse(const char* s, size_t len, Period* out) {
+    size_t i = 0;
+    bool neg = parse_sign(s, len, &i);
+    if (i == len || s[i] != 'P') {
+        return 0;
+    }
+    i++;
+    int count = 0;
+
+    // Date part: [-+]?[0-9]+[YMWD], in this order.
+    static const char date_units[] = "YMWD";
+    int64_t date[3] = {0, 0, 0};  // years, months, days
+    int next = 0;                 // first allowed designator
+    while (i < len && (is_digit(s[i]) || s[i] == '-' || s[i] == '+')) {
+        bool vneg = parse_sign(s, len, &i) != neg;
+        size_t start = i;
+        uint64_t v = parse_uint(s, len, &i);
+        if (i == start || i == len || v > (uint64_t)INT_MAX + 1) {
+            return 0;
+        }
+        const char* unit = memchr(date_units + next, s[i], sizeof(date_units) - 1 - (size_t)next);
+        if (unit == NULL) {
+            return 0;  // missing, unknown or out-of-order designator
+        }
+        int k = (int)(unit - date_units);
+        next = k + 1;
+        i++;
+        int64_t sv = vneg ? -(int64_t)v : (int64_t)v;
+        if (*unit == 'W') {
+            date[2] += sv * 7;
+        } else {
+            date[k < 2 ? k : 2] += sv;
+        }
+        count++;
+    }
+
+    // Time part: T([-+]?[0-9]+([.,][0-9]+)?[HMS])+, in this order.
+    Duration dur = 0;
+    if (i < len && s[i] == 'T') {
+        i++;
+        static const char time_units[] = "HMS";
+        const uint64_t unit_nsec[] = {TIME_HOUR, TIME_MINUTE, TIME_SECOND};
+        int tcount = 0;
+        next = 0;
+        while (i < len && (is_digit(s[i]) || s[i] == '-' || s[i] == '+')) {
+            bool vneg = parse_sign(s, len, &i) != neg;
+            size_t start = i;
+            uint64_t v = parse_uint(s, len, &i);
+            if (i == start) {
+                return 0;
+            }
+            size_t frac = i, nfrac = 0;
+            if (i < len && (s[i] == '.' || s[i] == ',')) {
+                i++;
+                frac = i;
+                while (i < len && is_digit(s[i])) {
+                    i++;
+                }
+                nfrac = i - frac;
+                if (nfrac == 0) {
+                    return 0;
+                }
+            }
+            if (i == len) {
+                return 0;
+            }
+            const char* unit =
+                memchr(time_units + next, s[i], sizeof(time_units) - 1 - (size_t)next);
+            if (unit == NULL) {
+                return 0;  // missing, unknown or out-of-order designator
+            }
+            int k = (int)(unit - time_units);
+            next = k + 1;
+            i++;
+
+            v = scale_decimal(v, s + frac, nfrac, unit_nsec[k]);
+            if (v > duration_maxabs || (!vneg && v == duration_maxabs)) {
+                return 0;  // overflow
+            }
+            Duration sv = vneg ? (v == duration_maxabs ? DURATION_MIN : -(Duration)v) : (Duration)v;
+            if ((sv > 0 && dur > DURATION_MAX - sv) || (sv < 0 && dur < DURATION_MIN - sv)) {
+                return 0;  // overflow
+            }
+            dur += sv;
+            tcount++;
+
+            if (nfrac > 0) {
+                // Only the last component may have a fraction.
+                if (i < len && (is_digit(s[i]) || s[i] == '-' || s[i] == '+')) {
+                    return 0;
+                }
+                break;
+            }
+        }
+        if (tcount == 0) {
+            return 0;  // T without components
+        }
+        count += tcount;
+    }
+
+    if (count == 0) {
+        return 0;  // P without components
+    }
+    for (int k = 0; k < 3; k++) {
+        if (date[k] < INT_MIN || date[k] > INT_MAX) {
+            return 0;  // overflow
+        }
+    }
+    out->years = (int)date[0];
+    out->months = (int)date[1];
+    out->days = (int)date[2];
+    out->duration = dur;
+    return i;
+}
@@ -6,45 +6,290 @@
 
 // Time formatting.
 
-#include <ctype.h>
-#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
 
+#if !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+#endif
+
 #include "vaqt.h"
 
-// parse_timezone_offset parses a timezone offset string in format ±HH:MM
-// and returns the offset in seconds. Returns true on success, false on failure.
-static bool parse_timezone_offset(const char* tz, int* offset_sec) {
-    if (tz[0] == '\0') {
-        *offset_sec = 0;
-        return true;
-    }
-    // Validate the timezone string format before parsing
-    if (tz[0] != '+' && tz[0] != '-') {
-        return false;  // Invalid sign
+// parse_digits parses exactly n decimal digits starting at s.
+// Returns false if any of the n characters is not a digit.
+static bool parse_digits(const char* s, int n, int* val) {
+    int v = 0;
+    for (int i = 0; i < n; i++) {
+        unsigned d = (unsigned char)s[i] - '0';
+        if (d > 9) {
+            return false;
+        }
+        v = v * 10 + (int)d;
     }
-    if (!isdigit((unsigned char)tz[1]) || !isdigit((unsigned char)tz[2])) {
-        return false;  // Invalid hours digits
+    *val = v;
+    return true;
+}
+
+// The SWAR (SIMD within a register) helpers below process 8 characters
+// at once as a 64-bit word, with s[0] in the lowest byte.
+static const uint64_t swar_ones = 0x0101010101010101;
+
+// load64 returns the 8 characters at s as a little-endian word.
+// Compilers turn this into a single load on little-endian machines.
+static inline uint64_t load64(const char* s) {
+    const unsigned char* p = (const unsigned char*)s;
+    return (uint64_t)p[0] | (uint64_t)p[1] << 8 | (uint64_t)p[2] << 16 | (uint64_t)p[3] << 24 |
+           (uint64_t)p[4] << 32 | (uint64_t)p[5] << 40 | (uint64_t)p[6] << 48 |
+           (uint64_t)p[7] << 56;
+}
+
+// swar_nondigits returns a word with the high bit set in each byte of w
+// that is not a decimal digit. A byte may be flagged by mistake only if
+// some lower byte is flagged too, so the lowest flagged byte is exact.
+static inline uint64_t swar_nondigits(uint64_t w) {
+    uint64_t t = w ^ (swar_ones * '0');  // digits become 0-9
+    return ((t + swar_ones * 0x76) | t) & (swar_ones * 0x80);
+}
+
+// swar_pairs returns a word where each byte i holds 10*d[i] + d[i+1],
+// the value of the two-digit number starting at byte i of w.
+static inline uint64_t swar_pairs(uint64_t w) {
+    uint64_t d = w & (swar_ones * 0x0F);
+    return d * 10 + (d >> 8);
+}
+
+// swar_eight returns the value of the eight-digit number in w,
+// given as digit values (0-9) rather than characters.
+static inline uint64_t swar_eight(uint64_t d) {
+    d = d * 10 + (d >> 8);  // pairs in bytes 0, 2, 4, 6
+    uint64_t lo = d & 0x000000FF000000FF;
+    uint64_t hi = (d >> 16) & 0x000000FF000000FF;
+    return (lo * (100 + (1000000ULL << 32)) + hi * (1 + (10000ULL << 32))) >> 32;
+}
+
+// parse_nsec parses up to max decimal digits of a fractional second
+// starting at s, and returns the number of digits parsed.
+static inline size_t parse_nsec(const char* s, size_t max, int* nsec) {
+    if (max >= 8) {
+        // Convert the first 8 digits at once, masking off the bytes
+        // starting from the first non-digit.
+        uint64_t w = load64(s);
+        uint64_t d = w & (swar_ones * 0x0F);
+        uint64_t nd = swar_nondigits(w);
+        size_t n = 8;
+        if (nd != 0) {
+            // The lowest flagged byte is 256^n, and multiplying by
+            // 0x0706050403020100 moves 7-n into the top byte.
+            uint64_t low = (nd & (~nd + 1)) >> 7;
+            n = 7 - (size_t)((low * 0x0706050403020100) >> 56);
+            d &= ((uint64_t)1 << (8 * n)) - 1;
+        }
+        uint64_t v = swar_eight(d) * 10;
+        if (n == 8 && max >= 9) {
+            unsigned ninth = (unsigned char)s[8] - '0';
+            if (ninth <= 9) {
+                v += ninth;
+                n = 9;
+            }
+        }
+        *nsec = (int)v;
+        return n;
     }
-    if (tz[3] != ':') {
-        return false;  // Missing colon separator
+
+    int v = 0;
+    size_t n = 0;
+    while (n < max) {
+        unsigned d = (unsigned char)s[n] - '0';
+        if (d > 9) {
+            break;
+        }
+        v = v * 10 + (int)d;
+        n++;
     }
-    if (!isdigit((unsigned char)tz[4]) || !isdigit((unsigned char)tz[5])) {
-        return false;  // Invalid minutes digits
+    for (size_t k = n; k < 9; k++) {
+        v *= 10;
     }
+    *nsec = v;
+    return n;
+}
+
+// parse_date parses a date in format YYYY-MM-DD (10 characters).
+static bool parse_date(const char* s, int* year, int* month, int* day) {
+    return parse_digits(s, 4, year) && s[4] == '-' && parse_digits(s + 5, 2, month) &&
+           s[7] == '-' && parse_digits(s + 8, 2, day);
+}
+
+// parse_clock parses a time of day in format HH:MM:SS (8 characters).
+static bool parse_clock(const char* s, int* hour, int* min, int* sec) {
+    return parse_digits(s, 2, hour) && s[2] == ':' && parse_digits(s + 3, 2, min) &&
+           s[5] == ':' && parse_digits(s + 6, 2, sec);
+}
 
-    // Parse timezone offset.
-    // + 0 7 : 0 0
-    // ⁰ ¹ ² ³ ⁴ ⁵
-    // tz[0] is the sign.
-    int sign = (tz[0] == '-') ? -1 : 1;
-    // tz[1] and tz[2] are hours.
-    *offset_sec = ((tz[1] - '0') * 10 + (tz[2] - '0')) * 3600 * sign;
-    // tz[4] and tz[5] are minutes.
-    *offset_sec += ((tz[4] - '0') * 10 + (tz[5] - '0')) * 60 * sign;
+// parse_timezone_offset parses a timezone offset in format ±HH:MM
+// (6 characters) at s[n] and returns the offset in seconds.
+// Reads the 8 characters ending with the offset, so n must be at least 2,
+// and the two characters before the offset must be the digits of the time
+// or of the fractional second (otherwise the result is unreliable).
+// Returns true on success, false on failure.
+static inline bool parse_timezone_offset(const char* s, size_t n, int* offset_sec) {
+    // 0 5 + 0 7 : 0 0
+    // ⁰ ¹ ² ³ ⁴ ⁵ ⁶ ⁷
+    uint64_t w = load64(s + n - 2);
+    uint64_t bad = (swar_nondigits(w) & 0x8080008080000000) |
+                   ((w & 0x0000FF0000000000) ^ 0x00003A0000000000);  // ':' separator
+    char sign = s[n];
+    if (bad != 0 || (sign != '+' && sign != '-')) {
+        return false;
+    }
+    w = swar_pairs(w);
+    int hour = (int)(w >> 24 & 0xFF);
+    int min = (int)(w >> 48 & 0xFF);
+    *offset_sec = (hour * 3600 + min * 60) * (sign == '-' ? -1 : 1);
     return true;
 }
 
+// digits2 holds the two-digit decimal representations of 0-99.
+static const char digits2[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// FMT_BUF_SIZE is the size of the scratch buffer used by the formatters.
+// It fits the longest possible ISO 8601 string, including a 32-bit year
+// and an out-of-range timezone offset.
+#define FMT_BUF_SIZE 64
+
+// put2 writes v (0-99) as two digits and returns the position after them.
+static char* put2(char* p, int v) {
+    memcpy(p, digits2 + 2 * v, 2);
+    return p + 2;
+}
+
+// put_int writes v zero-padded to at least width digits
+// and returns the position after them. v must not be negative.
+static char* put_int(char* p, unsigned v, int width) {
+    char tmp[10];
+    int n = 0;
+    do {
+        tmp[sizeof(tmp) - 1 - n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v > 0);
+    for (; n < width; n++) {
+        tmp[sizeof(tmp) - 1 - n] = '0';
+    }
+    memcpy(p, tmp + sizeof(tmp) - n, n);
+    return p + n;
+}
+
+// put_year writes the year like printf("%04d") does.
+static char* put_year(char* p, int year) {
+    if (year >= 0 && year <= 9999) {
+        p = put2(p, year / 100);
+        return put2(p, year % 100);
+    }
+    if (year < 0) {
+        *p++ = '-';
+        return put_int(p, 0u - (unsigned)year, 3);
+    }
+    return put_int(p, (unsigned)year, 4);
+}
+
+// put_date writes the date as 2006-01-02.
+static char* put_date(char* p, int year, int month, int day) {
+    p = put_year(p, year);
+    *p++ = '-';
+    p = put2(p, month);
+    *p++ = '-';
+    return put2(p, day);
+}
+
+// put_clock writes the time of day as 15:04:05.
+static char* put_clock(char* p, int hour, int min, int sec) {
+    p = put2(p, hour);
+    *p++ = ':';
+    p = put2(p, min);
+    *p++ = ':';
+    return put2(p, sec);
+}
+
+// put_nsec writes the nanoseconds as nine digits.
+static char* put_nsec(char* p, int nsec) {
+    p[8] = (char)('0' + nsec % 10);
+    nsec /= 10;
+    put2(p + 6, nsec % 100);
+    nsec /= 100;
+    put2(p + 4, nsec % 100);
+    nsec /= 100;
+    put2(p + 2, nsec % 100);
+    put2(p, nsec / 100);
+    return p + 9;
+}
+
+// put_frac writes the fractional second as a separator followed by
+// the given number of digits (at most 9). If trim is set, removes the
+// trailing zeros, and omits the fraction entirely if it is zero.
+static char* put_frac(char* p, int nsec, int digits, char sep, bool trim) {
+    if (trim && (digits == 0 || nsec == 0)) {
+        return p;
+    }
+    char tmp[9];
+    put_nsec(tmp, nsec);
+    if (trim) {
+        while (digits > 0 && tmp[digits - 1] == '0') {
+            digits--;
+        }
+    }
+    if (digits == 0) {
+        return p;
+    }
+    *p++ = sep;
+    memcpy(p, tmp, digits);
+    return p + digits;
+}
+
+// put_offset writes the timezone offset like printf("%+03d:%02d") does
+// with the offset hours and minutes. The sign comes from the offset itself,
+// so offsets under an hour (like -30 minutes) keep it, as in put_layout_tz.
+static char* put_offset(char* p, int offset_sec) {
+    unsigned abs_offset = offset_sec < 0 ? 0u - (unsigned)offset_sec : (unsigned)offset_sec;
+    *p++ = offset_sec < 0 ? '-' : '+';
+    p = put_int(p, abs_offset / 3600, 2);
+    *p++ = ':';
+    return put2(p, (int)(abs_offset % 3600 / 60));
+}
+
+// fmt_begin returns where a formatter should write its output.
+// Writes directly into buf if it is large enough for any output,
+// and into the scratch buffer otherwise.
+static char* fmt_begin(char* buf, size_t size, char* scratch) {
+    return size >= FMT_BUF_SIZE ? buf : scratch;
+}
+
+// fmt_end finishes formatting that started at begin and ended at end.
+// Behaves like snprintf: writes at most size-1 characters followed by
+// a NUL terminator, and returns the length of the full output.
+static size_t fmt_end(char* buf, size_t size, const char* begin, const char* end) {
+    size_t n = end - begin;
+    if (begin == buf) {
+        buf[n] = '\0';
+        return n;
+    }
+    if (size > 0) {
+        size_t m = n < size ? n : size - 1;
+        memcpy(buf, begin, m);
+        buf[m] = '\0';
+    }
+    return n;
+}
+
 // time_fmt_iso returns an ISO 8601 time string for the given time value.
 // Converts the time value to the given timezone offset before formatting.
 // Chooses the most compact representation:
@@ -52,41 +297,234 @@ static bool parse_timezone_offset(const char* tz, int* offset_sec) {
 //  - 2006-01-02T15:04:05.999999999Z
 //  - 2006-01-02T15:04:05+07:00
 //  - 2006-01-02T15:04:05Z
+// Like snprintf, writes at most size-1 characters followed by a NUL terminator,
+// and returns the length of the full string.
 size_t time_fmt_iso(Time t, int offset_sec, char* buf, size_t size) {
+    return time_fmt_iso_prec(t, offset_sec, t.nsec != 0 ? 9 : 0, buf, size);
+}
+
+// time_fmt_iso_prec returns an ISO 8601 time string for the given time value
+// with prec fractional second digits (0-9), truncating the extra digits:
+//  - 2006-01-02T15:04:05Z (prec = 0)
+//  - 2006-01-02T15:04:05.999Z (prec = 3)
+//  - 2006-01-02T15:04:05.999999999Z (prec = 9)
+// If prec is TIME_PREC_TRIM, writes up to nine digits without trailing zeros,
+// and omits the fraction entirely if it is zero (like Go's RFC3339Nano).
+// Converts the time value to the given timezone offset before formatting.
+// Like snprintf, writes at most size-1 characters followed by a NUL terminator,
+// and returns the length of the full string.
+size_t time_fmt_iso_prec(Time t, int offset_sec, int prec, char* buf, size_t size) {
     int year, day, hour, min, sec;
     enum Month month;
-    const char* layout;
-    size_t n = 0;
+    if (offset_sec != 0) {
+        t = time_add(t, offset_sec * TIME_SECOND);
+    }
+    time_get_date(t, &year, &month, &day);
+    time_get_clock(t, &hour, &min, &sec);
 
+    char scratch[FMT_BUF_SIZE];
+    char* begin = fmt_begin(buf, size, scratch);
+    char* p = put_date(begin, year, month, day);
+    *p++ = 'T';
+    p = put_clock(p, hour, min, sec);
+    if (prec < 0) {
+        p = put_frac(p, t.nsec, 9, '.', true);
+    } else if (prec > 0) {
+        p = put_frac(p, t.nsec, prec < 9 ? prec : 9, '.', false);
+    }
     if (offset_sec == 0) {
-        time_get_date(t, &year, &month, &day);
-        time_get_clock(t, &hour, &min, &sec);
-        if (t.nsec == 0) {
-            layout = "%04d-%02d-%02dT%02d:%02d:%02dZ";
-            n = snprintf(buf, size, layout, year, month, day, hour, min, sec);
-        } else {
-            layout = "%04d-%02d-%02dT%02d:%02d:%02d.%09dZ";
-            n = snprintf(buf, size, layout, year, month, day, hour, min, sec, t.nsec);
-        }
+        *p++ = 'Z';
     } else {
-        Time loc_t = time_add(t, offset_sec * TIME_SECOND);
-        time_get_date(loc_t, &year, &month, &day);
-        time_get_clock(loc_t, &hour, &min, &sec);
-        int ofhour = offset_sec / 3600;
-        int ofmin = (offset_sec % 3600) / 60;
-        if (ofmin < 0) {
-            ofmin = -ofmin;
-        }
-        if (loc_t.nsec == 0) {
-            layout = "%04d-%02d-%02dT%02d:%02d:%02d%+03d:%02d";
-            n = snprintf(buf, size, layout, year, month, day, hour, min, sec, ofhour, ofmin);
-        } else {
-            layout = "%04d-%02d-%02dT%02d:%02d:%02d.%09d%+03d:%02d";
-            n = snprintf(buf, size, layout, year, month, day, hour, min, sec, loc_t.nsec, ofhour,
-                         ofmin);
+        p = put_offset(p, offset_sec);
+    }
+    return fmt_end(buf, size, begin, p);
+}
+
+#define FMT_CHUNK 256
+
+// iso_frac_len returns the length of the fractional second written
+// by time_fmt_iso_prec, including the separator.
+static size_t iso_frac_len(int nsec, int prec) {
+    if (prec == 0) {
+        return 0;
+    }
+    if (prec > 0) {
+        return 1 + (size_t)(prec < 9 ? prec : 9);
+    }
+    if (nsec == 0) {
+        return 0;
+    }
+    size_t digits = 9;
+    for (; nsec % 10 == 0; nsec /= 10) {
+        digits--;
+    }
+    return 1 + digits;
+}
+
+// iso_year_len returns the length of the year written by put_year.
+static size_t iso_year_len(int year) {
+    if (year >= 0 && year <= 9999) {
+        return 4;
+    }
+    unsigned v = year < 0 ? 0u - (unsigned)year : (unsigned)year;
+    size_t n = 1;
+    for (; v >= 10; v /= 10) {
+        n++;
+    }
+    return year < 0 ? 1 + (n < 3 ? 3 : n) : n;
+}
+
+// iso_suffix writes the timezone suffix of an ISO 8601 string
+// and returns its length.
+static size_t iso_suffix(int offset_sec, char* tz) {
+    if (offset_sec == 0) {
+        tz[0] = 'Z';
+        return 1;
+    }
+    return (size_t)(put_offset(tz, offset_sec) - tz);
+}
+
+// time_fmt_iso_batch_size returns the number of bytes time_fmt_iso_batch
+// writes for the given time values, offset and precision.
+size_t time_fmt_iso_batch_size(const Time* in, size_t n, int offset_sec, int prec) {
+    char tz[FMT_BUF_SIZE];
+    size_t fixed = 15 + iso_suffix(offset_sec, tz);  // -01-02T15:04:05 and tz
+
+    // Years 0000-9999 take four digits.
+    int64_t min_sec = time_date(0, TIME_JANUARY, 1, 0, 0, 0, 0, offset_sec).sec;
+    int64_t max_sec = time_date(10000, TIME_JANUARY, 1, 0, 0, 0, 0, offset_sec).sec;
+
+    size_t total = 0;
+    for (size_t i = 0; i < n; i++) {
+        size_t year_len = 4;
+        if (in[i].sec < min_sec || in[i].sec >= max_sec) {
+            year_len = iso_year_len(time_get_year(time_add(in[i], offset_sec * TIME_SECOND)));
         }
+        total += year_len + fixed + iso_frac_len(in[i].nsec, prec);
     }
-    return n;
+    return total;
+}
+
+// time_fmt_iso_batch writes n ISO 8601 time strings back to back into buf,
+// as time_fmt_iso_prec would format them, without NUL terminators.
+// Converts the time values to the given timezone offset before formatting.
+//
+// If offsets is not NULL, stores n+1 offsets into it, as in an Arrow
+// string column: string i occupies buf[offsets[i]] to buf[offsets[i+1]-1].
+//
+// If offsets is NULL, all strings must have the same width, so string i
+// starts at buf[i*width]. This requires prec >= 0 and years 0000-9999.
+//
+// Returns the total number of bytes written (see time_fmt_iso_batch_size).
+// Returns 0 if buf is too small, if the total does not fit into the offsets,
+// or if the strings do not have the same width when offsets is NULL.
+size_t time_fmt_iso_batch(const Time* in,
+                          size_t n,
+                          int offset_sec,
+                          int prec,
+                          char* buf,
+                          size_t size,
+                          int32_t* offsets) {
+    if (offsets == NULL && prec < 0) {
+        return 0;
+    }
+    if (prec > 9) {
+        prec = 9;
+    }
+    char tz[FMT_BUF_SIZE];
+    size_t tz_len = iso_suffix(offset_sec, tz);
+    if (offsets != NULL) {
+        offsets[0] = 0;
+    }
+
+    Time shifted[FMT_CHUNK];
+    int year[FMT_CHUNK], month[FMT_CHUNK], day[FMT_CHUNK];
+    int hour[FMT_CHUNK], min[FMT_CHUNK], sec[FMT_CHUNK];
+    char* p = buf;
+    char* end = buf + size;
+    for (size_t i = 0; i < n; i += FMT_CHUNK) {
+        size_t m = n - i < FMT_CHUNK ? n - i : FMT_CHUNK;
+        for (size_t k = 0; k < m; k++) {
+            shifted[k] = time_add(in[i + k], offset_sec * TIME_SECOND);
+        }
+        time_get_date_batch(shifted, m, year, month, day);
+        time_get_clock_batch(shifted, m, hour, min, sec);
+
+        for (size_t k = 0; k < m; k++) {
+            if (offsets == NULL && (year[k] < 0 || year[k] > 9999)) {
+                return 0;
+            }
+            // Writes directly into buf while there is room for
+            // the longest string, and through a scratch buffer after.
+            char scratch[FMT_BUF_SIZE];
+            char* begin = end - p >= FMT_BUF_SIZE ? p : scratch;
+            char* q = put_date(begin, year[k], month[k], day[k]);
+            *q++ = 'T';
+            q = put_clock(q, hour[k], min[k], sec[k]);
+            q = put_frac(q, shifted[k].nsec, prec < 0 ? 9 : prec, '.', prec < 0);
+            memcpy(q, tz, tz_len);
+            q += tz_len;
+
+            size_t len = (size_t)(q - begin);
+            if (begin == scratch) {
+                if ((size_t)(end - p) < len) {
+                    return 0;
+                }
+                memcpy(p, scratch, len);
+            }
+            p += len;
+            if (offsets != NULL) {
+                if ((size_t)(p - buf) > INT32_MAX) {
+                    return 0;
+                }
+                offsets[i + k + 1] = (int32_t)(p - buf);
+            }
+        }
+    }
+    return (size_t)(p - buf);
+}
+
+// time_fmt_iso_cached returns the same ISO 8601 time string as time_fmt_iso_prec,
+// but keeps the formatted date and time of day (2006-01-02T15:04:05) and timezone
+// of the last call in the cache. When t falls within the same second with
+// the same offset, only writes the fractional second after the cached prefix.
+// Suited for formatting increasing timestamps, as loggers do.
+size_t time_fmt_iso_cached(TimeFmtCache* cache,
+                           Time t,
+                           int offset_sec,
+                           int prec,
+                           char* buf,
+                           size_t size) {
+    if (cache->prefix_len == 0 || cache->sec != t.sec || cache->offset_sec != offset_sec) {
+        int year, day, hour, min, sec;
+        enum Month month;
+        Time local = offset_sec != 0 ? time_add(t, offset_sec * TIME_SECOND) : t;
+        time_get_date(local, &year, &month, &day);
+        time_get_clock(local, &hour, &min, &sec);
+        char* p = put_date(cache->prefix, year, month, day);
+        *p++ = 'T';
+        p = put_clock(p, hour, min, sec);
+        cache->prefix_len = (uint8_t)(p - cache->prefix);
+        cache->suffix_len = (uint8_t)iso_suffix(offset_sec, cache->suffix);
+        cache->sec = t.sec;
+        cache->offset_sec = offset_sec;
+    }
+
+    // The output always fits into FMT_BUF_SIZE, so copy the whole
+    // prefix and suffix arrays, which is faster than copying
+    // a variable number of bytes.
+    char scratch[FMT_BUF_SIZE];
+    char* begin = fmt_begin(buf, size, scratch);
+    memcpy(begin, cache->prefix, sizeof(cache->prefix));
+    char* p = begin + cache->prefix_len;
+    if (prec < 0) {
+        p = put_frac(p, t.nsec, 9, '.', true);
+    } else if (prec > 0) {
+        p = put_frac(p, t.nsec, prec < 9 ? prec : 9, '.', false);
+    }
+    memcpy(p, cache->suffix, sizeof(cache->suffix));
+    p += cache->suffix_len;
+    return fmt_end(buf, size, begin, p);
 }
 
 // time_fmt_datetime returns a datetime string
@@ -95,15 +533,18 @@ size_t time_fmt_iso(Time t, int offset_sec, char* buf, size_t size) {
 size_t time_fmt_datetime(Time t, int offset_sec, char* buf, size_t size) {
     int year, day, hour, min, sec;
     enum Month month;
-    if (offset_sec == 0) {
-        time_get_date(t, &year, &month, &day);
-        time_get_clock(t, &hour, &min, &sec);
-    } else {
-        Time loc_t = time_add(t, offset_sec * TIME_SECOND);
-        time_get_date(loc_t, &year, &month, &day);
-        time_get_clock(loc_t, &hour, &min, &sec);
+    if (offset_sec != 0) {
+        t = time_add(t, offset_sec * TIME_SECOND);
     }
-    return snprintf(buf, size, "%04d-%02d-%02d %02d:%02d:%02d", year, month, day, hour, min, sec);
+    time_get_date(t, &year, &month, &day);
+    time_get_clock(t, &hour, &min, &sec);
+
+    char scratch[FMT_BUF_SIZE];
+    char* begin = fmt_begin(buf, size, scratch);
+    char* p = put_date(begin, year, month, day);
+    *p++ = ' ';
+    p = put_clock(p, hour, min, sec);
+    return fmt_end(buf, size, begin, p);
 }
 
 // time_fmt_date returns a date string
@@ -112,13 +553,15 @@ size_t time_fmt_datetime(Time t, int offset_sec, char* buf, size_t size) {
 size_t time_fmt_date(Time t, int offset_sec, char* buf, size_t size) {
     int year, day;
     enum Month month;
-    if (offset_sec == 0) {
-        time_get_date(t, &year, &month, &day);
-    } else {
-        Time loc_t = time_add(t, offset_sec * TIME_SECOND);
-        time_get_date(loc_t, &year, &month, &day);
+    if (offset_sec != 0) {
+        t = time_add(t, offset_sec * TIME_SECOND);
     }
-    return snprintf(buf, size, "%04d-%02d-%02d", year, month, day);
+    time_get_date(t, &year, &month, &day);
+
+    char scratch[FMT_BUF_SIZE];
+    char* begin = fmt_begin(buf, size, scratch);
+    char* p = put_date(begin, year, month, day);
+    return fmt_end(buf, size, begin, p);
 }
 
 // time_fmt_time returns a time string
@@ -126,89 +569,1203 @@ size_t time_fmt_date(Time t, int offset_sec, char* buf, size_t size) {
 // Converts the time value to the given timezone offset before formatting.
 size_t time_fmt_time(Time t, int offset_sec, char* buf, size_t size) {
     int hour, min, sec;
-    if (offset_sec == 0) {
+    if (offset_sec != 0) {
+        t = time_add(t, offset_sec * TIME_SECOND);
+    }
+    time_get_clock(t, &hour, &min, &sec);
+
+    char scratch[FMT_BUF_SIZE];
+    char* begin = fmt_begin(buf, size, scratch);
+    char* p = put_clock(begin, hour, min, sec);
+    return fmt_end(buf, size, begin, p);
+}
+
+// Operation codes of a compiled layout. Layout tokens follow Go:
+// https://pkg.go.dev/time#pkg-constants
+enum LayoutOp {
+    OP_LITERAL,               // literal text, arg = length
+    OP_LONG_MONTH,            // "January"
+    OP_MONTH,                 // "Jan"
+    OP_NUM_MONTH,             // "1"
+    OP_ZERO_MONTH,            // "01"
+    OP_LONG_WEEKDAY,          // "Monday"
+    OP_WEEKDAY,               // "Mon"
+    OP_DAY,                   // "2"
+    OP_UNDER_DAY,             // "_2"
+    OP_ZERO_DAY,              // "02"
+    OP_UNDER_YEARDAY,         // "__2"
+    OP_ZERO_YEARDAY,          // "002"
+    OP_HOUR,                  // "15"
+    OP_HOUR12,                // "3"
+    OP_ZERO_HOUR12,           // "03"
+    OP_MINUTE,                // "4"
+    OP_ZERO_MINUTE,           // "04"
+    OP_SECOND,                // "5"
+    OP_ZERO_SECOND,           // "05"
+    OP_LONG_YEAR,             // "2006"
+    OP_YEAR,                  // "06"
+    OP_PM,                    // "PM"
+    OP_LOWER_PM,              // "pm"
+    OP_TZ,                    // "MST"
+    OP_ISO_TZ,                // "Z0700"
+    OP_ISO_SECONDS_TZ,        // "Z070000"
+    OP_ISO_SHORT_TZ,          // "Z07"
+    OP_ISO_COLON_TZ,          // "Z07:00"
+    OP_ISO_COLON_SECONDS_TZ,  // "Z07:00:00"
+    OP_NUM_TZ,                // "-0700"
+    OP_NUM_SECONDS_TZ,        // "-070000"
+    OP_NUM_SHORT_TZ,          // "-07"
+    OP_NUM_COLON_TZ,          // "-07:00"
+    OP_NUM_COLON_SECONDS_TZ,  // "-07:00:00"
+    OP_FRAC,                  // ".000" or ",000", arg = digits | LAYOUT_COMMA
+    OP_FRAC_TRIM,             // ".999" or ",999", arg = digits | LAYOUT_COMMA
+};
+
+// LAYOUT_COMMA marks a fractional second with a comma separator.
+#define LAYOUT_COMMA 0x80
+
+// Time parts needed by layout operations.
+enum {
+    LAYOUT_NEEDS_DATE = 1,
+    LAYOUT_NEEDS_YEARDAY = 2,
+    LAYOUT_NEEDS_WEEKDAY = 4,
+    LAYOUT_NEEDS_CLOCK = 8,
+};
+
+static const char* const month_names[] = {
+    "January", "February", "March",     "April",   "May",      "June",
+    "July",    "August",   "September", "October", "November", "December",
+};
+
+static const char* const weekday_names[] = {
+    "Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday",
+};
+
+// LAYOUT_TZ_LEN is the maximum length of a formatted timezone offset,
+// including an out-of-range one (-596523:14:07).
+#define LAYOUT_TZ_LEN 13
+
+// LayoutToken describes a layout token: the operation,
+// the time parts it needs and the maximum length of its output.
+typedef struct {
+    const char* text;
+    uint8_t op;
+    uint8_t needs;
+    uint8_t max_len;
+} LayoutToken;
+
+// layout_tokens lists the fixed-text layout tokens. Longer tokens come
+// before their prefixes, so the first match is the longest one.
+static const LayoutToken layout_tokens[] = {
+    {"January", OP_LONG_MONTH, LAYOUT_NEEDS_DATE, 9},
+    {"Jan", OP_MONTH, LAYOUT_NEEDS_DATE, 3},
+    {"Monday", OP_LONG_WEEKDAY, LAYOUT_NEEDS_WEEKDAY, 9},
+    {"Mon", OP_WEEKDAY, LAYOUT_NEEDS_WEEKDAY, 3},
+    {"MST", OP_TZ, 0, LAYOUT_TZ_LEN},
+    {"002", OP_ZERO_YEARDAY, LAYOUT_NEEDS_YEARDAY, 3},
+    {"01", OP_ZERO_MONTH, LAYOUT_NEEDS_DATE, 2},
+    {"02", OP_ZERO_DAY, LAYOUT_NEEDS_DATE, 2},
+    {"03", OP_ZERO_HOUR12, LAYOUT_NEEDS_CLOCK, 2},
+    {"04", OP_ZERO_MINUTE, LAYOUT_NEEDS_CLOCK, 2},
+    {"05", OP_ZERO_SECOND, LAYOUT_NEEDS_CLOCK, 2},
+    {"06", OP_YEAR, LAYOUT_NEEDS_DATE, 2},
+    {"15", OP_HOUR, LAYOUT_NEEDS_CLOCK, 2},
+    {"1", OP_NUM_MONTH, LAYOUT_NEEDS_DATE, 2},
+    {"2006", OP_LONG_YEAR, LAYOUT_NEEDS_DATE, 11},
+    {"2", OP_DAY, LAYOUT_NEEDS_DATE, 2},
+    {"__2", OP_UNDER_YEARDAY, LAYOUT_NEEDS_YEARDAY, 3},
+    {"_2", OP_UNDER_DAY, LAYOUT_NEEDS_DATE, 2},
+    {"3", OP_HOUR12, LAYOUT_NEEDS_CLOCK, 2},
+    {"4", OP_MINUTE, LAYOUT_NEEDS_CLOCK, 2},
+    {"5", OP_SECOND, LAYOUT_NEEDS_CLOCK, 2},
+    {"PM", OP_PM, LAYOUT_NEEDS_CLOCK, 2},
+    {"pm", OP_LOWER_PM, LAYOUT_NEEDS_CLOCK, 2},
+    {"Z070000", OP_ISO_SECONDS_TZ, 0, LAYOUT_TZ_LEN},
+    {"Z07:00:00", OP_ISO_COLON_SECONDS_TZ, 0, LAYOUT_TZ_LEN},
+    {"Z0700", OP_ISO_TZ, 0, LAYOUT_TZ_LEN},
+    {"Z07:00", OP_ISO_COLON_TZ, 0, LAYOUT_TZ_LEN},
+    {"Z07", OP_ISO_SHORT_TZ, 0, LAYOUT_TZ_LEN},
+    {"-070000", OP_NUM_SECONDS_TZ, 0, LAYOUT_TZ_LEN},
+    {"-07:00:00", OP_NUM_COLON_SECONDS_TZ, 0, LAYOUT_TZ_LEN},
+    {"-0700", OP_NUM_TZ, 0, LAYOUT_TZ_LEN},
+    {"-07:00", OP_NUM_COLON_TZ, 0, LAYOUT_TZ_LEN},
+    {"-07", OP_NUM_SHORT_TZ, 0, LAYOUT_TZ_LEN},
+};
+
+// is_lower reports whether c is a lowercase ASCII letter.
+static bool is_lower(char c) {
+    return c >= 'a' && c <= 'z';
+}
+
+// layout_token finds the layout token at the beginning of s.
+// Returns the token length, or 0 if s does not start with a token.
+static size_t layout_token(const char* s, LayoutToken* tok) {
+    // Fractional seconds: ".000", ".999", ",000", ",999".
+    if ((s[0] == '.' || s[0] == ',') && (s[1] == '0' || s[1] == '9')) {
+        size_t n = 1;
+        while (s[n] == s[1]) {
+            n++;
+        }
+        if (s[n] >= '0' && s[n] <= '9') {
+            return 0;  // a number, not a fraction
+        }
+        size_t digits = n - 1 < 9 ? n - 1 : 9;
+        tok->op = s[1] == '0' ? OP_FRAC : OP_FRAC_TRIM;
+        tok->needs = 0;
+        tok->max_len = (uint8_t)(digits + 1);
+        tok->text = s[0] == ',' ? "," : ".";
+        return n;
+    }
+    // "_2006" is a literal underscore followed by a year.
+    if (strncmp(s, "_2006", 5) == 0) {
+        return 0;
+    }
+    for (size_t i = 0; i < sizeof(layout_tokens) / sizeof(layout_tokens[0]); i++) {
+        const char* text = layout_tokens[i].text;
+        size_t n = strlen(text);
+        if (strncmp(s, text, n) != 0) {
+            continue;
+        }
+        // "Jan" and "Mon" only count if they are not the start of a word.
+        if ((layout_tokens[i].op == OP_MONTH || layout_tokens[i].op == OP_WEEKDAY) &&
+            is_lower(s[n])) {
+            continue;
+        }
+        *tok = layout_tokens[i];
+        return n;
+    }
+    return 0;
+}
+
+// layout_add appends an operation to the layout.
+// Returns false if the layout is full.
+static bool layout_add(TimeLayout* l, uint8_t op, uint8_t arg, size_t max_len) {
+    if (l->nops == TIME_LAYOUT_MAX_OPS) {
+        return false;
+    }
+    l->ops[l->nops] = op;
+    l->args[l->nops] = arg;
+    l->nops++;
+    l->max_len = (uint16_t)(l->max_len + max_len);
+    return true;
+}
+
+// time_layout_compile compiles a Go-style layout for use with time_fmt_layout.
+// The layout shows how the reference time, Mon Jan 2 15:04:05 MST 2006,
+// would be formatted, for example "2006-01-02T15:04:05.000Z07:00".
+// See https://pkg.go.dev/time#pkg-constants for the list of tokens.
+// Text that is not a token is copied to the output as is.
+// Since vaqt has no time zone names, "MST" formats as "UTC" for the zero
+// offset and as "-0700" for other offsets.
+// Returns false if the layout has more than TIME_LAYOUT_MAX_OPS tokens
+// and literal chunks, or more than TIME_LAYOUT_MAX_TEXT bytes of literal text.
+bool time_layout_compile(const char* layout, TimeLayout* out) {
+    TimeLayout l = {0};
+    size_t ntext = 0;
+    size_t nlit = 0;  // length of the pending literal chunk
+    const char* s = layout;
+    while (*s != '\0') {
+        LayoutToken tok;
+        size_t n = layout_token(s, &tok);
+        if (n == 0) {
+            if (ntext == TIME_LAYOUT_MAX_TEXT) {
+                return false;
+            }
+            l.text[ntext++] = *s++;
+            nlit++;
+            continue;
+        }
+        if (nlit > 0 && !layout_add(&l, OP_LITERAL, (uint8_t)nlit, nlit)) {
+            return false;
+        }
+        nlit = 0;
+        uint8_t arg = 0;
+        if (tok.op == OP_FRAC || tok.op == OP_FRAC_TRIM) {
+            arg = (uint8_t)((tok.max_len - 1) | (tok.text[0] == ',' ? LAYOUT_COMMA : 0));
+        }
+        if (!layout_add(&l, tok.op, arg, tok.max_len)) {
+            return false;
+        }
+        l.needs |= tok.needs;
+        s += n;
+    }
+    if (nlit > 0 && !layout_add(&l, OP_LITERAL, (uint8_t)nlit, nlit)) {
+        return false;
+    }
+    *out = l;
+    return true;
+}
+
+// put_signed writes v zero-padded to at least width digits, with a minus
+// sign if v is negative, and returns the position after them.
+static char* put_signed(char* p, int v, int width) {
+    if (v < 0) {
+        *p++ = '-';
+        return put_int(p, 0u - (unsigned)v, width);
+    }
+    return put_int(p, (unsigned)v, width);
+}
+
+// put_str writes the NUL-terminated string s and returns the position after it.
+static char* put_str(char* p, const char* s) {
+    size_t n = strlen(s);
+    memcpy(p, s, n);
+    return p + n;
+}
+
+// put_layout_tz writes the timezone offset for one of the numeric
+// timezone operations, like Go does.
+static char* put_layout_tz(char* p, uint8_t op, int offset_sec) {
+    if (offset_sec == 0 && op >= OP_ISO_TZ && op <= OP_ISO_COLON_SECONDS_TZ) {
+        *p++ = 'Z';
+        return p;
+    }
+    // Take the sign from the offset itself rather than from the minutes,
+    // which are zero for offsets under a minute (like -30 seconds).
+    int abs_offset = offset_sec < 0 ? -offset_sec : offset_sec;
+    int zone = abs_offset / 60;  // minutes
+    *p++ = offset_sec < 0 ? '-' : '+';
+    p = zone < 100 * 60 ? put2(p, zone / 60) : put_int(p, (unsigned)(zone / 60), 2);
+    bool colon = op == OP_ISO_COLON_TZ || op == OP_ISO_COLON_SECONDS_TZ ||
+                 op == OP_NUM_COLON_TZ || op == OP_NUM_COLON_SECONDS_TZ;
+    if (colon) {
+        *p++ = ':';
+    }
+    if (op != OP_ISO_SHORT_TZ && op != OP_NUM_SHORT_TZ) {
+        p = put2(p, zone % 60);
+    }
+    if (op == OP_ISO_SECONDS_TZ || op == OP_ISO_COLON_SECONDS_TZ || op == OP_NUM_SECONDS_TZ ||
+        op == OP_NUM_COLON_SECONDS_TZ) {
+        if (colon) {
+            *p++ = ':';
+        }
+        p = put2(p, abs_offset % 60);
+    }
+    return p;
+}
+
+// time_fmt_layout returns a string for the given time value
+// formatted according to the layout compiled with time_layout_compile.
+// Converts the time value to the given timezone offset before formatting.
+// Like snprintf, writes at most size-1 characters followed by a NUL terminator,
+// and returns the length of the full string.
+size_t time_fmt_layout(Time t, int offset_sec, const TimeLayout* layout, char* buf, size_t size) {
+    if (offset_sec != 0) {
+        t = time_add(t, offset_sec * TIME_SECOND);
+    }
+    int year = 0, day = 0, yday = 0, hour = 0, min = 0, sec = 0;
+    enum Month month = TIME_JANUARY;
+    enum Weekday weekday = TIME_SUNDAY;
+    if (layout->needs & LAYOUT_NEEDS_DATE) {
+        time_get_date(t, &year, &month, &day);
+    }
+    if (layout->needs & LAYOUT_NEEDS_YEARDAY) {
+        yday = time_get_yearday(t);
+    }
+    if (layout->needs & LAYOUT_NEEDS_WEEKDAY) {
+        weekday = time_get_weekday(t);
+    }
+    if (layout->needs & LAYOUT_NEEDS_CLOCK) {
         time_get_clock(t, &hour, &min, &sec);
+    }
+
+    char scratch[TIME_LAYOUT_MAX_OPS * LAYOUT_TZ_LEN + TIME_LAYOUT_MAX_TEXT];
+    char* begin = size > layout->max_len ? buf : scratch;
+    char* p = begin;
+    const char* text = layout->text;
+    size_t nops = layout->nops;
+    for (size_t i = 0; i < nops; i++) {
+        uint8_t op = layout->ops[i];
+        uint8_t arg = layout->args[i];
+        switch (op) {
+            case OP_LITERAL:
+                if (arg == 1) {
+                    *p++ = *text++;
+                    break;
+                }
+                memcpy(p, text, arg);
+                p += arg;
+                text += arg;
+                break;
+            case OP_LONG_MONTH:
+                p = put_str(p, month_names[month - 1]);
+                break;
+            case OP_MONTH:
+                memcpy(p, month_names[month - 1], 3);
+                p += 3;
+                break;
+            case OP_NUM_MONTH:
+                p = put_int(p, (unsigned)month, 1);
+                break;
+            case OP_ZERO_MONTH:
+                p = put2(p, month);
+                break;
+            case OP_LONG_WEEKDAY:
+                p = put_str(p, weekday_names[weekday]);
+                break;
+            case OP_WEEKDAY:
+                memcpy(p, weekday_names[weekday], 3);
+                p += 3;
+                break;
+            case OP_DAY:
+                p = put_int(p, (unsigned)day, 1);
+                break;
+            case OP_UNDER_DAY:
+                if (day < 10) {
+                    *p++ = ' ';
+                }
+                p = put_int(p, (unsigned)day, 1);
+                break;
+            case OP_ZERO_DAY:
+                p = put2(p, day);
+                break;
+            case OP_UNDER_YEARDAY:
+                if (yday < 100) {
+                    *p++ = ' ';
+                }
+                if (yday < 10) {
+                    *p++ = ' ';
+                }
+                p = put_int(p, (unsigned)yday, 1);
+                break;
+            case OP_ZERO_YEARDAY:
+                p = put_int(p, (unsigned)yday, 3);
+                break;
+            case OP_HOUR:
+                p = put2(p, hour);
+                break;
+            case OP_HOUR12:
+                p = put_int(p, (unsigned)(hour % 12 == 0 ? 12 : hour % 12), 1);
+                break;
+            case OP_ZERO_HOUR12:
+                p = put2(p, hour % 12 == 0 ? 12 : hour % 12);
+                break;
+            case OP_MINUTE:
+                p = put_int(p, (unsigned)min, 1);
+                break;
+            case OP_ZERO_MINUTE:
+                p = put2(p, min);
+                break;
+            case OP_SECOND:
+                p = put_int(p, (unsigned)sec, 1);
+                break;
+            case OP_ZERO_SECOND:
+                p = put2(p, sec);
+                break;
+            case OP_LONG_YEAR:
+                p = year >= 0 ? put_year(p, year) : put_signed(p, year, 4);
+                break;
+            case OP_YEAR:
+                p = put2(p, (year < 0 ? -(year % 100) : year % 100));
+                break;
+            case OP_PM:
+                p = put_str(p, hour >= 12 ? "PM" : "AM");
+                break;
+            case OP_LOWER_PM:
+                p = put_str(p, hour >= 12 ? "pm" : "am");
+                break;
+            case OP_TZ:
+                if (offset_sec == 0) {
+                    p = put_str(p, "UTC");
+                } else {
+                    p = put_layout_tz(p, OP_NUM_TZ, offset_sec);
+                }
+                break;
+            case OP_FRAC:
+            case OP_FRAC_TRIM:
+                p = put_frac(p, t.nsec, arg & ~LAYOUT_COMMA, arg & LAYOUT_COMMA ? ',' : '.',
+                             op == OP_FRAC_TRIM);
+                break;
+            default:
+                p = put_layout_tz(p, op, offset_sec);
+                break;
+        }
+    }
+    return fmt_end(buf, size, begin, p);
+}
+
+// IsoFields holds the fields of a parsed ISO 8601 time string.
+typedef struct {
+    int year, month, day, hour, min, sec, nsec, offset_sec;
+} IsoFields;
+
+// parse_datetime parses a date and time in format YYYY-MM-DDTHH:MM:SS
+// or YYYY-MM-DD HH:MM:SS (19 characters). Validates all the digits and
+// separators at once and converts the digit pairs in-register, so it is
+// several times faster than parse_date followed by parse_clock.
+static inline bool parse_datetime(const char* s, IsoFields* f) {
+    // 2 0 0 6 - 0 1 - 0 2 T 1 5 : 0 4 : 0 5
+    // ⁰         ⁵         ¹⁰        ¹⁵
+    uint64_t date = load64(s);        // "2006-01-"
+    uint64_t days = load64(s + 8);    // "02T15:04"
+    uint64_t clock = load64(s + 11);  // "15:04:05"
+    uint64_t bad = (swar_nondigits(date) & 0x0080800080808080) |
+                   (swar_nondigits(days) & 0x0000000000008080) |
+                   (swar_nondigits(clock) & 0x8080008080008080) |
+                   ((date & 0xFF0000FF00000000) ^ 0x2D00002D00000000) |  // '-' separators
+                   ((clock & 0x0000FF0000FF0000) ^ 0x00003A00003A0000);  // ':' separators
+    if (bad != 0 || (s[10] != 'T' && s[10] != ' ')) {
+        return false;
+    }
+    date = swar_pairs(date);
+    days = swar_pairs(days);
+    clock = swar_pairs(clock);
+    f->year = (int)(date & 0xFF) * 100 + (int)(date >> 16 & 0xFF);
+    f->month = (int)(date >> 40 & 0xFF);
+    f->day = (int)(days & 0xFF);
+    f->hour = (int)(clock & 0xFF);
+    f->min = (int)(clock >> 24 & 0xFF);
+    f->sec = (int)(clock >> 48 & 0xFF);
+    return true;
+}
+
+// parse_iso parses a time value at the beginning of s, reading at most len bytes,
+// into fields. Returns the number of bytes consumed, or 0 on failure.
+static size_t parse_iso(const char* s, size_t len, IsoFields* f) {
+    *f = (IsoFields){1, 1, 1, 0, 0, 0, 0, 0};
+    size_t n = 0;
+
+    // 2 0 0 6 - 0 1 - 0 2 T 1 5 : 0 4 : 0 5 . 9 9 9 9 9 9 9 9 9 + 0 7 : 0 0
+    // ⁰         ⁵         ¹⁰        ¹⁵        ²⁰        ²⁵        ³⁰
+    if (len >= 8 && s[2] == ':') {
+        // "15:04:05"
+        if (!parse_clock(s, &f->hour, &f->min, &f->sec)) {
+            return 0;
+        }
+        n = 8;
+    } else if (len >= 19 && parse_datetime(s, f)) {
+        // "2006-01-02T15:04:05"
+        n = 19;
+
+        // ".999999999" (1 to 9 digits)
+        if (len > 20 && s[19] == '.') {
+            size_t digits = parse_nsec(s + 20, len - 20 < 9 ? len - 20 : 9, &f->nsec);
+            n += digits > 0 ? 1 + digits : 0;
+        }
+
+        // "Z" or "+07:00"
+        if (len > n && s[n] == 'Z') {
+            n += 1;
+        } else if (len >= n + 6 && parse_timezone_offset(s, n, &f->offset_sec)) {
+            n += 6;
+        }
     } else {
-        Time loc_t = time_add(t, offset_sec * TIME_SECOND);
-        time_get_clock(loc_t, &hour, &min, &sec);
+        // "2006-01-02"
+        if (len < 10 || !parse_date(s, &f->year, &f->month, &f->day)) {
+            return 0;
+        }
+        n = 10;
+    }
+    return n;
+}
+
+// time_parse_n parses a time value at the beginning of s, reading at most len bytes.
+// Does not require s to be NUL-terminated, and does not read past s[len-1].
+// Accepts the same layouts as time_parse, choosing the longest one that matches.
+// The date and time may be separated by either 'T' or a space.
+// On success, stores the time value in *out and returns the number of bytes consumed.
+// On failure, leaves *out unchanged and returns 0.
+size_t time_parse_n(const char* s, size_t len, Time* out) {
+    IsoFields f;
+    size_t n = parse_iso(s, len, &f);
+    if (n == 0) {
+        return 0;
+    }
+    *out = time_date(f.year, (enum Month)f.month, f.day, f.hour, f.min, f.sec, f.nsec,
+                     f.offset_sec);
+    return n;
+}
+
+#define PARSE_CHUNK 256
+
+// IsoShape describes the layout of a fixed-width ISO 8601 string:
+// which parts are present, and how many fractional second digits it has.
+typedef struct {
+    bool has_date;
+    bool has_clock;
+    uint8_t frac;  // number of fractional second digits, 0 if none
+    char tz;       // 'Z', '+' for a numeric offset, or 0 if none
+} IsoShape;
+
+// iso_shape returns the shape of a valid ISO 8601 string of len bytes.
+static IsoShape iso_shape(const char* s, size_t len) {
+    IsoShape sh = {true, true, 0, 0};
+    if (len == 8 && s[2] == ':') {
+        sh.has_date = false;
+        return sh;
+    }
+    if (len == 10) {
+        sh.has_clock = false;
+        return sh;
+    }
+    size_t n = 19;
+    if (len > n && s[n] == '.') {
+        while (n + 1 + sh.frac < len && s[n + 1 + sh.frac] >= '0' && s[n + 1 + sh.frac] <= '9') {
+            sh.frac++;
+        }
+        n += 1 + sh.frac;
+    }
+    if (len > n) {
+        sh.tz = s[n] == 'Z' ? 'Z' : '+';
+    }
+    return sh;
+}
+
+// parse_iso_fixed parses a string with the given shape into f.
+// Does not look at the length: the caller ensures that the string
+// is exactly as long as the shape requires.
+static bool parse_iso_fixed(const char* s, const IsoShape* sh, IsoFields* f) {
+    *f = (IsoFields){1, 1, 1, 0, 0, 0, 0, 0};
+    if (!sh->has_date) {
+        return parse_clock(s, &f->hour, &f->min, &f->sec);
+    }
+    if (!sh->has_clock) {
+        return parse_date(s, &f->year, &f->month, &f->day);
+    }
+    if (!parse_datetime(s, f)) {
+        return false;
+    }
+    size_t n = 19;
+    if (sh->frac > 0) {
+        if (s[n] != '.' || parse_nsec(s + n + 1, sh->frac, &f->nsec) != sh->frac) {
+            return false;
+        }
+        n += 1 + sh->frac;
+    }
+    if (sh->tz == 'Z') {
+        return s[n] == 'Z';
+    }
+    if (sh->tz == '+') {
+        return parse_timezone_offset(s, n, &f->offset_sec);
+    }
+    return true;
+}
+
+// parse_chunk parses up to PARSE_CHUNK strings into out, and sets
+// the corresponding bits in valid (which must be byte-aligned).
+// Returns the number of valid rows.
+static size_t parse_chunk(const char* const* strs,
+                          const size_t* lens,
+                          size_t n,
+                          Time* out,
+                          uint8_t* valid) {
+    int year[PARSE_CHUNK], month[PARSE_CHUNK], day[PARSE_CHUNK];
+    int hour[PARSE_CHUNK], min[PARSE_CHUNK], sec[PARSE_CHUNK];
+    int nsec[PARSE_CHUNK], offset[PARSE_CHUNK];
+    uint8_t ok[PARSE_CHUNK];
+
+    // When all rows have the same length, they most likely share the shape
+    // of the first valid row, so check that shape first and fall back to
+    // the general parser only for the rows that do not match it.
+    bool fixed = n > 0;
+    for (size_t i = 1; i < n && fixed; i++) {
+        fixed = lens[i] == lens[0];
+    }
+    IsoShape shape = {0};
+    bool has_shape = false;
+
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++) {
+        IsoFields f;
+        bool row_ok = false;
+        if (strs[i] != NULL) {
+            if (has_shape && parse_iso_fixed(strs[i], &shape, &f)) {
+                row_ok = true;
+            } else {
+                row_ok = parse_iso(strs[i], lens[i], &f) == lens[i] && lens[i] > 0;
+                if (row_ok && fixed && !has_shape) {
+                    shape = iso_shape(strs[i], lens[i]);
+                    has_shape = true;
+                }
+            }
+        }
+        if (!row_ok) {
+            // The fields of the zero time.
+            f = (IsoFields){1, 1, 1, 0, 0, 0, 0, 0};
+        }
+        year[i] = f.year;
+        month[i] = f.month;
+        day[i] = f.day;
+        hour[i] = f.hour;
+        min[i] = f.min;
+        sec[i] = f.sec;
+        nsec[i] = f.nsec;
+        offset[i] = f.offset_sec;
+        ok[i] = row_ok;
+        count += row_ok;
+    }
+
+    time_date_batch(year, month, day, hour, min, sec, nsec, offset, 0, n, out);
+
+    if (valid != NULL) {
+        for (size_t i = 0; i < n; i += 8) {
+            uint8_t bits = 0;
+            for (size_t k = 0; k < 8 && i + k < n; k++) {
+                bits |= (uint8_t)(ok[i + k] << k);
+            }
+            valid[i / 8] = bits;
+        }
+    }
+    return count;
+}
+
+// time_parse_batch parses n strings, given as pointers and lengths,
+// into out. Each string must match one of the layouts accepted by
+// time_parse as a whole. Does not stop at invalid strings: sets their
+// time values to the zero time and clears their bits in the valid bitmap.
+//
+// valid is an Arrow-style validity bitmap of (n+7)/8 bytes, with
+// the bit for row i at valid[i/8] & (1 << (i%8)). May be NULL.
+// The unused high bits of the last byte are set to zero.
+// NULL strings are considered invalid.
+// Returns the number of valid rows.
+size_t time_parse_batch(const char* const* strs,
+                        const size_t* lens,
+                        size_t n,
+                        Time* out,
+                        uint8_t* valid) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; i += PARSE_CHUNK) {
+        size_t m = n - i < PARSE_CHUNK ? n - i : PARSE_CHUNK;
+        count += parse_chunk(strs + i, lens + i, m, out + i, valid ? valid + i / 8 : NULL);
+    }
+    return count;
+}
+
+// time_parse_batch_offsets is like time_parse_batch, but takes the strings
+// as a contiguous data buffer plus n+1 offsets, as in an Arrow string column:
+// string i occupies data[offsets[i]] to data[offsets[i+1]-1].
+size_t time_parse_batch_offsets(const char* data,
+                                const int32_t* offsets,
+                                size_t n,
+                                Time* out,
+                                uint8_t* valid) {
+    const char* strs[PARSE_CHUNK];
+    size_t lens[PARSE_CHUNK];
+    size_t count = 0;
+    for (size_t i = 0; i < n; i += PARSE_CHUNK) {
+        size_t m = n - i < PARSE_CHUNK ? n - i : PARSE_CHUNK;
+        for (size_t k = 0; k < m; k++) {
+            int32_t start = offsets[i + k];
+            int32_t end = offsets[i + k + 1];
+            strs[k] = end >= start ? data + start : NULL;
+            lens[k] = end >= start ? (size_t)(end - start) : 0;
+        }
+        count += parse_chunk(strs, lens, m, out + i, valid ? valid + i / 8 : NULL);
+    }
+    return count;
+}
+
+// parse_num parses between min and max decimal digits at s[*i], reading
+// no further than s[len-1], and advances *i past them.
+static bool parse_num(const char* s, size_t len, size_t* i, int min, int max, int* val) {
+    int v = 0;
+    int n = 0;
+    while (n < max && *i + n < len) {
+        unsigned d = (unsigned char)s[*i + n] - '0';
+        if (d > 9) {
+            break;
+        }
+        v = v * 10 + (int)d;
+        n++;
+    }
+    if (n < min) {
+        return false;
+    }
+    *i += n;
+    *val = v;
+    return true;
+}
+
+// to_lower returns the lowercase version of an ASCII letter c.
+static char to_lower(char c) {
+    return c >= 'A' && c <= 'Z' ? (char)(c - 'A' + 'a') : c;
+}
+
+// parse_name matches one of the names at s[*i] case-insensitively,
+// comparing the first n characters (or the whole name if n is 0).
+// Returns the index of the matched name, or -1 if none matches.
+static int parse_name(const char* s,
+                      size_t len,
+                      size_t* i,
+                      const char* const* names,
+                      int count,
+                      size_t n) {
+    for (int k = 0; k < count; k++) {
+        size_t m = n > 0 ? n : strlen(names[k]);
+        if (len - *i < m) {
+            continue;
+        }
+        size_t j = 0;
+        while (j < m && to_lower(s[*i + j]) == to_lower(names[k][j])) {
+            j++;
+        }
+        if (j == m) {
+            *i += m;
+            return k;
+        }
+    }
+    return -1;
+}
+
+// parse_frac parses a fractional second at s[*i]: a period or a comma
+// followed by digits. Reads exactly digits digits if digits is not 0,
+// and all of them otherwise. Digits beyond the ninth are ignored.
+static bool parse_frac(const char* s, size_t len, size_t* i, int digits, int* nsec) {
+    if (*i >= len || (s[*i] != '.' && s[*i] != ',')) {
+        return false;
+    }
+    size_t j = *i + 1;
+    int v = 0;
+    int n = 0;
+    while (j < len && (digits == 0 || n < digits)) {
+        unsigned d = (unsigned char)s[j] - '0';
+        if (d > 9) {
+            break;
+        }
+        if (n < 9) {
+            v = v * 10 + (int)d;
+        }
+        n++;
+        j++;
+    }
+    if (n == 0 || (digits != 0 && n < digits)) {
+        return false;
+    }
+    for (int k = n; k < 9; k++) {
+        v *= 10;
+    }
+    *i = j;
+    *nsec = v;
+    return true;
+}
+
+// parse_layout_tz parses the timezone offset for one of the numeric
+// timezone operations, like Go does.
+static bool parse_layout_tz(const char* s, size_t len, size_t* i, uint8_t op, int* offset_sec) {
+    if (op >= OP_ISO_TZ && op <= OP_ISO_COLON_SECONDS_TZ && *i < len && s[*i] == 'Z') {
+        *i += 1;
+        *offset_sec = 0;
+        return true;
+    }
+    if (*i >= len || (s[*i] != '+' && s[*i] != '-')) {
+        return false;
+    }
+    int sign = s[*i] == '-' ? -1 : 1;
+    bool colon = op == OP_ISO_COLON_TZ || op == OP_ISO_COLON_SECONDS_TZ ||
+                 op == OP_NUM_COLON_TZ || op == OP_NUM_COLON_SECONDS_TZ;
+    bool has_min = op != OP_ISO_SHORT_TZ && op != OP_NUM_SHORT_TZ;
+    bool has_sec = op == OP_ISO_SECONDS_TZ || op == OP_ISO_COLON_SECONDS_TZ ||
+                   op == OP_NUM_SECONDS_TZ || op == OP_NUM_COLON_SECONDS_TZ;
+    size_t j = *i + 1;
+    int hour = 0, min = 0, sec = 0;
+    if (!parse_num(s, len, &j, 2, 2, &hour)) {
+        return false;
+    }
+    if (has_min) {
+        if (colon && (j >= len || s[j++] != ':')) {
+            return false;
+        }
+        if (!parse_num(s, len, &j, 2, 2, &min)) {
+            return false;
+        }
+    }
+    if (has_sec) {
+        if (colon && (j >= len || s[j++] != ':')) {
+            return false;
+        }
+        if (!parse_num(s, len, &j, 2, 2, &sec)) {
+            return false;
+        }
+    }
+    if (hour > 24 || min > 59 || sec > 59) {
+        return false;
+    }
+    *i = j;
+    *offset_sec = sign * (hour * 3600 + min * 60 + sec);
+    return true;
+}
+
+// days_in_month returns the number of days in the month (1-12) of the year.
+// Uses the same leap-year rule as is_leap in time.c.
+static int days_in_month(int year, int month) {
+    if (month == TIME_FEBRUARY) {
+        bool leap = (year & 3) == 0 && (year % 25 != 0 || (year & 15) == 0);
+        return leap ? 29 : 28;
     }
-    return snprintf(buf, size, "%02d:%02d:%02d", hour, min, sec);
+    return 30 + ((month + (month >> 3)) & 1);
+}
+
+// time_parse_layout parses a time value at the beginning of s, reading at most
+// len bytes, according to the layout compiled with time_layout_compile.
+// Does not require s to be NUL-terminated, and does not read past s[len-1].
+// Accepts the same tokens as time_fmt_layout, with these rules:
+//  - Month and weekday names are case-insensitive. The weekday is checked
+//    for syntax but otherwise ignored.
+//  - "1", "2", "3", "4", "5" and "15" accept one or two digits,
+//    "_2" accepts an optional leading space, "__2" up to two leading spaces.
+//  - "2006" accepts exactly four digits, "06" two digits (69-99 mean 19xx).
+//  - "MST" accepts "UTC", "GMT" or a -0700 style offset.
+//  - ".000" requires exactly that many digits, ".999" makes the fraction
+//    optional, and a fraction right after seconds is accepted even if
+//    the layout does not have one.
+// Elements omitted from the layout are assumed to be those of the zero time
+// (January 1, year 1, 00:00:00 UTC).
+// On success, stores the time value in *out and returns the number of bytes consumed.
+// On failure, leaves *out unchanged, stores the offset of the element that
+// failed to parse in *err_pos (if err_pos is not NULL), and returns 0.
+size_t time_parse_layout(const char* s,
+                         size_t len,
+                         const TimeLayout* layout,
+                         Time* out,
+                         size_t* err_pos) {
+    int year = 1, month = 1, day = 1, yday = 0, hour = 0, min = 0, sec = 0, nsec = 0;
+    int offset_sec = 0;
+    bool pm_set = false, am_set = false, month_set = false, day_set = false;
+    size_t day_pos = 0, yday_pos = 0;
+
+    size_t i = 0;
+    const char* text = layout->text;
+    size_t nops = layout->nops;
+    for (size_t k = 0; k < nops; k++) {
+        uint8_t op = layout->ops[k];
+        uint8_t arg = layout->args[k];
+        size_t pos = i;
+        bool ok = true;
+        switch (op) {
+            case OP_LITERAL:
+                ok = len - i >= arg && memcmp(s + i, text, arg) == 0;
+                i += ok ? arg : 0;
+                text += arg;
+                break;
+            case OP_LONG_MONTH:
+            case OP_MONTH: {
+                int m = parse_name(s, len, &i, month_names, 12, op == OP_MONTH ? 3 : 0);
+                ok = m >= 0;
+                month = m + 1;
+                month_set = true;
+                break;
+            }
+            case OP_NUM_MONTH:
+            case OP_ZERO_MONTH:
+                ok = parse_num(s, len, &i, op == OP_ZERO_MONTH ? 2 : 1, 2, &month) &&
+                     month >= 1 && month <= 12;
+                month_set = true;
+                break;
+            case OP_LONG_WEEKDAY:
+            case OP_WEEKDAY:
+                ok = parse_name(s, len, &i, weekday_names, 7, op == OP_WEEKDAY ? 3 : 0) >= 0;
+                break;
+            case OP_UNDER_DAY:
+                if (i < len && s[i] == ' ') {
+                    i++;
+                }
+                // fallthrough
+            case OP_DAY:
+            case OP_ZERO_DAY:
+                day_pos = pos;
+                ok = parse_num(s, len, &i, op == OP_ZERO_DAY ? 2 : 1, 2, &day) && day >= 1;
+                day_set = true;
+                break;
+            case OP_UNDER_YEARDAY:
+                for (int n = 0; n < 2 && i < len && s[i] == ' '; n++) {
+                    i++;
+                }
+                // fallthrough
+            case OP_ZERO_YEARDAY:
+                yday_pos = pos;
+                ok = parse_num(s, len, &i, op == OP_ZERO_YEARDAY ? 3 : 1, 3, &yday) &&
+                     yday >= 1 && yday <= 366;
+                break;
+            case OP_HOUR:
+                ok = parse_num(s, len, &i, 1, 2, &hour) && hour <= 23;
+                break;
+            case OP_HOUR12:
+            case OP_ZERO_HOUR12:
+                ok = parse_num(s, len, &i, op == OP_ZERO_HOUR12 ? 2 : 1, 2, &hour) && hour <= 12;
+                break;
+            case OP_MINUTE:
+            case OP_ZERO_MINUTE:
+                ok = parse_num(s, len, &i, op == OP_ZERO_MINUTE ? 2 : 1, 2, &min) && min <= 59;
+                break;
+            case OP_SECOND:
+            case OP_ZERO_SECOND:
+                ok = parse_num(s, len, &i, op == OP_ZERO_SECOND ? 2 : 1, 2, &sec) && sec <= 59;
+                // A fractional second right after seconds, unless the layout has one.
+                if (ok && (k + 1 == nops || (layout->ops[k + 1] != OP_FRAC &&
+                                             layout->ops[k + 1] != OP_FRAC_TRIM))) {
+                    parse_frac(s, len, &i, 0, &nsec);
+                }
+                break;
+            case OP_LONG_YEAR:
+                ok = parse_num(s, len, &i, 4, 4, &year);
+                break;
+            case OP_YEAR:
+                ok = parse_num(s, len, &i, 2, 2, &year);
+                year += year >= 69 ? 1900 : 2000;
+                break;
+            case OP_PM:
+            case OP_LOWER_PM: {
+                const char* ampm = op == OP_PM ? "AMPM" : "ampm";
+                ok = len - i >= 2 && s[i + 1] == ampm[1] && (s[i] == ampm[0] || s[i] == ampm[2]);
+                if (ok) {
+                    am_set = s[i] == ampm[0];
+                    pm_set = !am_set;
+                    i += 2;
+                }
+                break;
+            }
+            case OP_TZ:
+                if (len - i >= 3 &&
+                    (memcmp(s + i, "UTC", 3) == 0 || memcmp(s + i, "GMT", 3) == 0)) {
+                    offset_sec = 0;
+                    i += 3;
+                } else {
+                    ok = parse_layout_tz(s, len, &i, OP_NUM_TZ, &offset_sec);
+                }
+                break;
+            case OP_FRAC:
+                ok = parse_frac(s, len, &i, arg & ~LAYOUT_COMMA, &nsec);
+                break;
+            case OP_FRAC_TRIM:
+                // The fraction is optional.
+                if (len - i >= 2 && (s[i] == '.' || s[i] == ',') && s[i + 1] >= '0' &&
+                    s[i + 1] <= '9') {
+                    parse_frac(s, len, &i, 0, &nsec);
+                }
+                break;
+            default:
+                ok = parse_layout_tz(s, len, &i, op, &offset_sec);
+                break;
+        }
+        if (!ok) {
+            if (err_pos != NULL) {
+                *err_pos = pos;
+            }
+            return 0;
+        }
+    }
+
+    if (pm_set && hour < 12) {
+        hour += 12;
+    } else if (am_set && hour == 12) {
+        hour = 0;
+    }
+
+    if (yday > 0) {
+        // Convert the day of the year to the month and day,
+        // and check that they agree with the parsed ones.
+        int yd_year, yd_day;
+        enum Month yd_month;
+        time_get_date(time_date(year, TIME_JANUARY, yday, 0, 0, 0, 0, 0), &yd_year, &yd_month,
+                      &yd_day);
+        bool mismatch = yd_year != year || (month_set && (int)yd_month != month) ||
+                        (day_set && yd_day != day);
+        if (mismatch) {
+            if (err_pos != NULL) {
+                *err_pos = yday_pos;
+            }
+            return 0;
+        }
+        month = yd_month;
+        day = yd_day;
+    } else if (day > days_in_month(year, month)) {
+        if (err_pos != NULL) {
+            *err_pos = day_pos;
+        }
+        return 0;
+    }
+
+    *out = time_date(year, (enum Month)month, day, hour, min, sec, nsec, offset_sec);
+    return i;
 }
 
 // time_parse parses a formatted string and returns the time value it represents.
 // Supports a limited set of layouts:
-// - "2006-01-02T15:04:05.999999999+07:00" (ISO 8601 with nanoseconds and timezone)
-// - "2006-01-02T15:04:05.999999999Z" (ISO 8601 with nanoseconds, UTC)
+// - "2006-01-02T15:04:05.999999999+07:00" (ISO 8601 with fractional seconds and timezone)
+// - "2006-01-02T15:04:05.999999999Z" (ISO 8601 with fractional seconds, UTC)
 // - "2006-01-02T15:04:05+07:00" (ISO 8601 with timezone)
 // - "2006-01-02T15:04:05Z" (ISO 8601, UTC)
 // - "2006-01-02 15:04:05" (date and time, UTC)
 // - "2006-01-02" (date only, UTC)
 // - "15:04:05" (time only, UTC)
+// The fractional seconds may have from 1 to 9 digits.
+// Returns the zero time if the string does not match any of the layouts.
 Time time_parse(const char* value) {
-    Time zero = {0, 0};
+    Time t = {0, 0};
     size_t len = strlen(value);
-    if (len < 8 || len > 35) {
-        return zero;
+    size_t n = time_parse_n(value, len, &t);
+    if (n == 0 || n != len) {
+        return (Time){0, 0};
     }
+    return t;
+}
 
-    int year = 1, month = 1, day = 1, hour = 0, min = 0, sec = 0, nsec = 0, offset_sec = 0;
-    char tz[7] = "";
+// time_fmt_http returns an HTTP date string (IMF-fixdate, as defined
+// in RFC 7231) for the given time value: Sun, 06 Nov 1994 08:49:37 GMT.
+// HTTP dates are always in UTC. Years outside 0000-9999 are written
+// like time_fmt_iso does, although HTTP does not allow them.
+// Like snprintf, writes at most size-1 characters followed by a NUL terminator,
+// and returns the length of the full string.
+size_t time_fmt_http(Time t, char* buf, size_t size) {
+    int year, day, hour, min, sec;
+    enum Month month;
+    time_get_date(t, &year, &month, &day);
+    time_get_clock(t, &hour, &min, &sec);
+    enum Weekday weekday = time_get_weekday(t);
 
-    if (len == 35) {
-        // "2006-01-02T15:04:05.999999999+07:00"
-        int n = sscanf(value, "%d-%d-%dT%d:%d:%d.%d%6s", &year, &month, &day, &hour, &min, &sec,
-                       &nsec, tz);
-        if (n != 8) {
-            return zero;
-        }
-    }
+    char scratch[FMT_BUF_SIZE];
+    char* begin = fmt_begin(buf, size, scratch);
+    char* p = begin;
+    memcpy(p, weekday_names[weekday], 3);
+    memcpy(p + 3, ", ", 2);
+    p = put2(p + 5, day);
+    *p++ = ' ';
+    memcpy(p, month_names[month - 1], 3);
+    p[3] = ' ';
+    p = put_year(p + 4, year);
+    *p++ = ' ';
+    p = put_clock(p, hour, min, sec);
+    memcpy(p, " GMT", 4);
+    return fmt_end(buf, size, begin, p + 4);
+}
 
-    if (len == 30) {
-        // "2006-01-02T15:04:05.999999999Z"
-        int n =
-            sscanf(value, "%d-%d-%dT%d:%d:%d.%dZ", &year, &month, &day, &hour, &min, &sec, &nsec);
-        if (n != 7) {
-            return zero;
-        }
-    }
+#if !defined(__STDC_NO_ATOMICS__)
+// http_cache_* hold the last HTTP date formatted by time_fmt_http_cached,
+// guarded by a sequence lock: the sequence number is odd while they are
+// updated, and zero while the cache is empty. The date is stored as words
+// so that readers can load it atomically, with its length in the last byte.
+static _Atomic uint32_t http_cache_seq;
+static _Atomic int64_t http_cache_sec;
+static _Atomic uint64_t http_cache_text[4];
+
+// http_cache_lock is held by the thread that updates the cache.
+static atomic_flag http_cache_lock = ATOMIC_FLAG_INIT;
+#endif
 
-    if (len == 25) {
-        // "2006-01-02T15:04:05+07:00"
-        int n = sscanf(value, "%d-%d-%dT%d:%d:%d%6s", &year, &month, &day, &hour, &min, &sec, tz);
-        if (n != 7) {
-            return zero;
+// time_fmt_http_cached returns the same HTTP date string as time_fmt_http,
+// but formats it at most once per second, sharing the result between
+// all threads. Safe to call concurrently. Never blocks: if another thread
+// is updating the cache, formats the date without it.
+size_t time_fmt_http_cached(Time t, char* buf, size_t size) {
+#if !defined(__STDC_NO_ATOMICS__)
+    uint64_t text[4];
+    uint32_t seq = atomic_load_explicit(&http_cache_seq, memory_order_acquire);
+    if (seq != 0 && (seq & 1) == 0) {
+        // Copies the words straight into buf if it is large enough,
+        // and validates them afterwards (the caller does not see buf
+        // until the function returns).
+        char* dst = size >= sizeof(text) ? buf : (char*)text;
+        int64_t sec = atomic_load_explicit(&http_cache_sec, memory_order_relaxed);
+        for (int k = 0; k < 4; k++) {
+            uint64_t w = atomic_load_explicit(&http_cache_text[k], memory_order_relaxed);
+            memcpy(dst + 8 * k, &w, 8);
+        }
+        atomic_thread_fence(memory_order_acquire);
+        if (sec == t.sec && atomic_load_explicit(&http_cache_seq, memory_order_relaxed) == seq) {
+            size_t n = (unsigned char)dst[sizeof(text) - 1];
+            return fmt_end(buf, size, dst, dst + n);
         }
     }
 
-    if (len == 19 || len == 20) {
-        // "2006-01-02T15:04:05Z"
-        // "2006-01-02 15:04:05"
-        int n = sscanf(value, "%d-%d-%d%*c%d:%d:%d", &year, &month, &day, &hour, &min, &sec);
-        if (n != 6) {
-            return zero;
+    // Not in the cache: format and publish, unless someone else is doing it.
+    char* s = (char*)text;
+    size_t n = time_fmt_http(t, s, sizeof(text));
+    if (n < sizeof(text) &&
+        !atomic_flag_test_and_set_explicit(&http_cache_lock, memory_order_acquire)) {
+        s[sizeof(text) - 1] = (char)n;
+        seq = atomic_load_explicit(&http_cache_seq, memory_order_relaxed);
+        atomic_store_explicit(&http_cache_seq, seq + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        atomic_store_explicit(&http_cache_sec, t.sec, memory_order_relaxed);
+        for (int k = 0; k < 4; k++) {
+            atomic_store_explicit(&http_cache_text[k], text[k], memory_order_relaxed);
         }
+        atomic_store_explicit(&http_cache_seq, seq + 2 != 0 ? seq + 2 : 2, memory_order_release);
+        atomic_flag_clear_explicit(&http_cache_lock, memory_order_release);
     }
+    if (n < sizeof(text)) {
+        return fmt_end(buf, size, s, s + n);
+    }
+#endif
+    return time_fmt_http(t, buf, size);
+}
 
-    if (len == 10) {
-        // "2006-01-02"
-        int n = sscanf(value, "%d-%d-%d", &year, &month, &day);
-        if (n != 3) {
-            return zero;
-        }
+// parse_lit matches the literal string lit at s[*i], and advances *i past it.
+static bool parse_lit(const char* s, size_t len, size_t* i, const char* lit) {
+    size_t n = strlen(lit);
+    if (len - *i < n || memcmp(s + *i, lit, n) != 0) {
+        return false;
     }
+    *i += n;
+    return true;
+}
 
-    if (len == 8) {
-        // "15:04:05"
-        int n = sscanf(value, "%d:%d:%d", &hour, &min, &sec);
-        if (n != 3) {
-            return zero;
+// parse_http_clock parses the time of day of an HTTP date (15:04:05) at s[*i].
+static bool parse_http_clock(const char* s, size_t len, size_t* i, int* hour, int* min, int* sec) {
+    return parse_num(s, len, i, 2, 2, hour) && parse_lit(s, len, i, ":") &&
+           parse_num(s, len, i, 2, 2, min) && parse_lit(s, len, i, ":") &&
+           parse_num(s, len, i, 2, 2, sec);
+}
+
+// time_parse_http parses an HTTP date at the beginning of s, reading at most
+// len bytes. Accepts the three formats allowed by RFC 7231:
+// - "Sun, 06 Nov 1994 08:49:37 GMT" (IMF-fixdate)
+// - "Sunday, 06-Nov-94 08:49:37 GMT" (obsolete RFC 850 format)
+// - "Sun Nov  6 08:49:37 1994" (obsolete ANSI C asctime format)
+// In the RFC 850 format, years 69-99 mean 19xx, and 00-68 mean 20xx.
+// Month and weekday names are case-insensitive. The weekday is checked
+// for syntax but otherwise ignored.
+// On success, stores the time value in *out and returns the number of bytes consumed.
+// On failure, leaves *out unchanged and returns 0.
+size_t time_parse_http(const char* s, size_t len, Time* out) {
+    size_t i = 0;
+    int year, month, day, hour, min, sec;
+    if (parse_name(s, len, &i, weekday_names, 7, 3) < 0 || i == len) {
+        return 0;
+    }
+    if (s[i] == ',') {
+        // Sun, 06 Nov 1994 08:49:37 GMT
+        i++;
+        if (!parse_lit(s, len, &i, " ") || !parse_num(s, len, &i, 2, 2, &day) ||
+            !parse_lit(s, len, &i, " ") ||
+            (month = parse_name(s, len, &i, month_names, 12, 3)) < 0 ||
+            !parse_lit(s, len, &i, " ") || !parse_num(s, len, &i, 4, 4, &year) ||
+            !parse_lit(s, len, &i, " ") || !parse_http_clock(s, len, &i, &hour, &min, &sec) ||
+            !parse_lit(s, len, &i, " GMT")) {
+            return 0;
+        }
+    } else if (s[i] == ' ') {
+        // Sun Nov  6 08:49:37 1994
+        i++;
+        if ((month = parse_name(s, len, &i, month_names, 12, 3)) < 0 ||
+            !parse_lit(s, len, &i, " ")) {
+            return 0;
         }
+        bool padded = parse_lit(s, len, &i, " ");
+        if (!parse_num(s, len, &i, padded ? 1 : 2, padded ? 1 : 2, &day) ||
+            !parse_lit(s, len, &i, " ") || !parse_http_clock(s, len, &i, &hour, &min, &sec) ||
+            !parse_lit(s, len, &i, " ") || !parse_num(s, len, &i, 4, 4, &year)) {
+            return 0;
+        }
+    } else {
+        // Sunday, 06-Nov-94 08:49:37 GMT
+        i = 0;
+        if (parse_name(s, len, &i, weekday_names, 7, 0) < 0 || !parse_lit(s, len, &i, ", ") ||
+            !parse_num(s, len, &i, 2, 2, &day) || !parse_lit(s, len, &i, "-") ||
+            (month = parse_name(s, len, &i, month_names, 12, 3)) < 0 ||
+            !parse_lit(s, len, &i, "-") || !parse_num(s, len, &i, 2, 2, &year) ||
+            !parse_lit(s, len, &i, " ") || !parse_http_clock(s, len, &i, &hour, &min, &sec) ||
+            !parse_lit(s, len, &i, " GMT")) {
+            return 0;
+        }
+        year += year >= 69 ? 1900 : 2000;
     }
 
-    if (!parse_timezone_offset(tz, &offset_sec)) {
-        // Invalid timezone offset.
-        return zero;
+    month++;
+    if (day < 1 || day > days_in_month(year, month) || hour > 23 || min > 59 || sec > 59) {
+        return 0;
     }
-
-    return time_date(year, (enum Month)month, day, hour, min, sec, nsec, offset_sec);
+    *out = time_date(year, (enum Month)month, day, hour, min, sec, 0, 0);
+    return i;
 }
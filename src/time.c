@@ -31,11 +31,7 @@ static const int64_t seconds_per_week = 7 * seconds_per_day;
 
 // Gregorian calendar constants:
 // - 400 years = 303 regular years + 97 leap years
-// - 100 years = 76 regular years + 24 leap years
-// - 4 years = 3 regular years + 1 leap year
 static const int64_t days_per_400_years = 365 * 400 + 97;
-static const int64_t days_per_100_years = 365 * 100 + 24;
-static const int64_t days_per_4_years = 365 * 4 + 1;
 
 // The absolute zero year for internal calculations.
 // This is year 1 in the proleptic Gregorian calendar.
@@ -101,39 +97,24 @@ static void norm(int hi, int lo, int base, int* nhi, int* nlo) {
 // - Years divisible by 4 are leap years
 // - Except years divisible by 100 are not leap years
 // - Except years divisible by 400 are leap years
-// The calculation breaks down the year into 400-year, 100-year, 4-year, and 1-year cycles
-// for efficient computation.
-static uint64_t days_since_epoch(int year) {
+//
+// Since the absolute epoch starts a 400-year cycle, the number of leap years
+// before year y (counting from the epoch) is y/4 - y/100 + y/400, so the result
+// is 365*y + y/4 - y/100 + y/400. Following Neri and Schneider, "Euclidean affine
+// functions and their application to calendar algorithms" (2022), it is computed as
+// 1461*y/4 - c + c/4 with c = y/100, where the divisions by powers of two are shifts,
+// and the division by a constant 100 compiles to a multiply and a shift.
+static uint64_t days_since_epoch(int64_t year) {
     uint64_t y = year - absolute_zero_year;
-
-    // Add in days from complete 400-year cycles.
-    // Each 400-year cycle has 97 leap years (400/4 - 400/100 + 400/400 = 100 - 4 + 1 = 97)
-    uint64_t n = y / 400;
-    y -= 400 * n;
-    uint64_t d = days_per_400_years * n;
-
-    // Add in days from complete 100-year cycles within remaining years.
-    // Each 100-year cycle has 24 leap years (100/4 - 100/100 = 25 - 1 = 24)
-    n = y / 100;
-    y -= 100 * n;
-    d += days_per_100_years * n;
-
-    // Add in days from complete 4-year cycles within remaining years.
-    // Each 4-year cycle has 1 leap year
-    n = y / 4;
-    y -= 4 * n;
-    d += days_per_4_years * n;
-
-    // Add in days from remaining non-leap years.
-    n = y;
-    d += 365 * n;
-
-    return d;
+    uint64_t c = y / 100;
+    return ((1461 * y) >> 2) - c + (c >> 2);
 }
 
 // is_leap reports whether the year is a leap year.
+// A year divisible by 4 is divisible by 100 exactly when it is divisible by 25,
+// and divisible by 400 exactly when it is also divisible by 16.
 static bool is_leap(int year) {
-    return year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+    return (year & 3) == 0 && (year % 25 != 0 || (year & 15) == 0);
 }
 
 static int64_t unix_sec(Time t) {
@@ -147,7 +128,7 @@ static Time unix_time(int64_t sec, int32_t nsec) {
 // abs_time returns the time t as an absolute time, adjusted by the zone offset.
 // It is called when computing a presentation property like Month or Hour.
 static uint64_t abs_time(Time t) {
-    return t.sec + internal_to_absolute;
+    return (uint64_t)t.sec + (uint64_t)internal_to_absolute;
 }
 
 // abs_weekday is like Weekday but operates on an absolute time.
@@ -157,83 +138,74 @@ static enum Weekday abs_weekday(uint64_t abs) {
     return sec / seconds_per_day;
 }
 
+// abs_civil converts an absolute time in seconds to the corresponding year
+// of the computational calendar, the day within that year (0-365),
+// and whether the day falls into January or February.
+//
+// The computational calendar starts years on March 1, so the leap day
+// is always the last day of the year, and month lengths follow a regular
+// pattern. It uses the Euclidean affine functions from Neri and Schneider,
+// "Euclidean affine functions and their application to calendar algorithms"
+// (2022), which replace the 400/100/4-year cycle cascade with a few
+// multiplications and shifts.
+static void abs_civil(uint64_t abs, int* year, uint32_t* cday, bool* jan_feb) {
+    // Days since March 1 of the year before the absolute zero year.
+    // That year starts a 400-year cycle, and January 1 is 306 days after March 1.
+    uint64_t n = abs / seconds_per_day + 306;
+
+    // Century and day of the century. The division by the constant
+    // compiles to a multiply and a shift.
+    uint64_t n1 = 4 * n + 3;
+    uint64_t century = n1 / days_per_400_years;
+    uint32_t ncen = (uint32_t)(n1 % days_per_400_years) / 4;
+
+    // Year of the century and day of the year, from one 64-bit product:
+    // 2939745 / 2^32 approximates 1 / 1461 closely enough to be exact here.
+    uint64_t p2 = UINT64_C(2939745) * (4 * ncen + 3);
+    uint32_t ycen = (uint32_t)(p2 >> 32);
+    uint32_t nyear = (uint32_t)p2 / 2939745 / 4;
+
+    *jan_feb = nyear >= 306;
+    *year = 100 * century + ycen + *jan_feb + absolute_zero_year - 1;
+    *cday = nyear;
+}
+
 // abs_date converts an absolute time in seconds to the corresponding
-// year and day-of-year (1-366).
+// year and day-of-year (0-365).
 static void abs_date(uint64_t abs, int* year, int* yday) {
-    // Split into time and day.
-    uint64_t d = abs / seconds_per_day;
-
-    // Account for 400 year cycles.
-    uint64_t n = d / days_per_400_years;
-    uint64_t y = 400 * n;
-    d -= days_per_400_years * n;
-
-    // Cut off 100-year cycles.
-    // The last cycle has one extra leap year, so on the last day
-    // of that year, day / days_per_100_years will be 4 instead of 3.
-    // Cut it back down to 3 by subtracting n>>2.
-    n = d / days_per_100_years;
-    n -= n >> 2;
-    y += 100 * n;
-    d -= days_per_100_years * n;
-
-    // Cut off 4-year cycles.
-    // The last cycle has a missing leap year, which does not
-    // affect the computation.
-    n = d / days_per_4_years;
-    y += 4 * n;
-    d -= days_per_4_years * n;
-
-    // Cut off years within a 4-year cycle.
-    // The last year is a leap year, so on the last day of that year,
-    // day / 365 will be 4 instead of 3. Cut it back down to 3
-    // by subtracting n>>2.
-    n = d / 365;
-    n -= n >> 2;
-    y += n;
-    d -= 365 * n;
-
-    *year = y + absolute_zero_year;
-    *yday = d;
+    uint32_t cday;
+    bool jan_feb;
+    abs_civil(abs, year, &cday, &jan_feb);
+    if (jan_feb) {
+        // January and February close the computational year.
+        *yday = cday - 306;
+    } else {
+        // March 1 is day 59 of the year, or 60 in leap years.
+        *yday = cday + 31 + 28 + is_leap(*year);
+    }
 }
 
 // abs_date_full converts an absolute time in seconds to the corresponding
-// year, month, day, and day-of-year (1-366).
+// year, month, day, and day-of-year (0-365).
 static void abs_date_full(uint64_t abs, int* year, enum Month* month, int* day, int* yday) {
-    abs_date(abs, year, yday);
-
-    *day = *yday;
-    if (is_leap(*year)) {
-        // In leap years, February has 29 days instead of 28.
-        // The day-of-year (*yday) includes the leap day, but we need to handle it specially
-        // when converting to month/day format.
-        if (*day > 31 + 29 - 1) {
-            // After February 29 (day 60 in leap year), subtract 1 to account for the extra day
-            // that was already included in the day-of-year count.
-            *day -= 1;
-        }
-        if (*day == 31 + 29 - 1) {
-            // This is February 29 (the leap day) - day 60 in a leap year.
-            *month = TIME_FEBRUARY;
-            *day = 29;
-            return;
-        }
-    }
-
-    // Estimate month by assuming every month has 31 days.
-    // This gives an initial guess that may be off by at most one month.
-    *month = *day / 31;
-    int end = days_before[(int)(*month) + 1];
-    int begin;
-    if (*day >= end) {
-        *month += 1;
-        begin = end;
+    uint32_t cday;
+    bool jan_feb;
+    abs_civil(abs, year, &cday, &jan_feb);
+
+    // Month and day from the day of the computational year.
+    // 2141 / 2^16 approximates 1 / 30.6, the average length of a month
+    // from March to January; 197913 shifts March to month 3.
+    uint32_t n3 = 2141 * cday + 197913;
+    uint32_t m = n3 >> 16;
+    *day = (n3 & 0xFFFF) / 2141 + 1;
+
+    if (jan_feb) {
+        *month = m - 12;
+        *yday = cday - 306;
     } else {
-        begin = days_before[(int)(*month)];
+        *month = m;
+        *yday = cday + 31 + 28 + is_leap(*year);
     }
-
-    *month += 1;  // Convert from 0-based to 1-based month (January = 1)
-    *day = *day - begin + 1;
 }
 
 // abs_clock converts an absolute time in seconds to the corresponding
@@ -246,6 +218,40 @@ void abs_clock(uint64_t abs, int* hour, int* min, int* sec) {
     *sec -= *min * seconds_per_minute;
 }
 
+// iso_week converts a year, zero-based day of the year and weekday
+// to the corresponding ISO 8601 year and week number.
+static void iso_week(int year, int yday, enum Weekday weekday, int* iso_year, int* week) {
+    // According to the rule that the first calendar week of a calendar year is
+    // the week including the first Thursday of that year, and that the last one
+    // is the week immediately preceding the first calendar week of the next
+    // calendar year. See
+    // https://www.iso.org/obp/ui#iso:std:iso:8601:-1:ed-1:v1:en:term:3.1.1.23 for
+    // details.
+
+    // weeks start with Monday
+    // Monday Tuesday Wednesday Thursday Friday Saturday Sunday
+    // 1      2       3         4        5      6        7
+    // +3     +2      +1        0        -1     -2       -3
+    // the offset to Thursday
+    int d = (TIME_THURSDAY - weekday);
+    // handle Sunday
+    if (d == 4) {
+        d = -3;
+    }
+    // find the Thursday of the calendar week,
+    // which may fall into the previous or the next year
+    yday += d;
+    if (yday < 0) {
+        year--;
+        yday += is_leap(year) ? 366 : 365;
+    } else if (yday >= (is_leap(year) ? 366 : 365)) {
+        yday -= is_leap(year) ? 366 : 365;
+        year++;
+    }
+    *iso_year = year;
+    *week = yday / 7 + 1;
+}
+
 // tless_than_half reports whether x+x < y but avoids overflow,
 // assuming x and y are both positive (Duration is signed).
 static bool tless_than_half(Duration x, Duration y) {
@@ -454,29 +460,335 @@ int time_get_yearday(Time t) {
 // week 52 or 53 of year n-1, and Dec 29 to Dec 31 might belong to week 1 of
 // year n+1.
 void time_get_isoweek(Time t, int* year, int* week) {
-    // According to the rule that the first calendar week of a calendar year is
-    // the week including the first Thursday of that year, and that the last one
-    // is the week immediately preceding the first calendar week of the next
-    // calendar year. See
-    // https://www.iso.org/obp/ui#iso:std:iso:8601:-1:ed-1:v1:en:term:3.1.1.23 for
-    // details.
-
-    // weeks start with Monday
-    // Monday Tuesday Wednesday Thursday Friday Saturday Sunday
-    // 1      2       3         4        5      6        7
-    // +3     +2      +1        0        -1     -2       -3
-    // the offset to Thursday
     uint64_t abs = abs_time(t);
-    int d = (TIME_THURSDAY - abs_weekday(abs));
-    // handle Sunday
-    if (d == 4) {
-        d = -3;
-    }
-    // find the Thursday of the calendar week
     int yday;
-    abs += d * seconds_per_day;
     abs_date(abs, year, &yday);
-    *week = yday / 7 + 1;
+    iso_week(*year, yday, abs_weekday(abs), year, week);
+}
+
+// time_get_fields returns all the calendar and clock fields of t at once.
+// Decomposes t only once, so it is cheaper than calling several
+// of the individual getters.
+void time_get_fields(Time t, TimeFields* fields) {
+    uint64_t abs = abs_time(t);
+    int yday;
+    abs_date_full(abs, &fields->year, &fields->month, &fields->day, &yday);
+    fields->yday = yday + 1;
+    fields->weekday = abs_weekday(abs);
+    abs_clock(abs, &fields->hour, &fields->min, &fields->sec);
+    fields->nsec = t.nsec;
+    iso_week(fields->year, yday, fields->weekday, &fields->iso_year, &fields->iso_week);
+}
+
+// ## Batch time parts
+
+// The batch functions decompose arrays of time values in chunks.
+// Each chunk is processed within a window of 2^32 seconds (about 136 years)
+// around its first element, so the per-element calendar math runs on 32-bit
+// integers with constant divisors, which compilers can vectorize. Elements
+// outside the window (rare in real-world columns) go through the scalar path.
+#define BATCH_CHUNK 256
+
+// BATCH_KERNEL marks the per-chunk kernels. On x86-64 Linux, each kernel is
+// compiled both for the baseline instruction set (SSE2) and for AVX2, and the
+// loader picks the best one for the CPU at startup. Elsewhere (including
+// AArch64, where NEON is part of the baseline) the kernels are compiled once.
+#if defined(__has_attribute) && defined(__x86_64__) && defined(__linux__) && !defined(__AVX2__)
+#if __has_attribute(target_clones)
+#define BATCH_KERNEL __attribute__((target_clones("avx2", "default")))
+#endif
+#endif
+#ifndef BATCH_KERNEL
+#define BATCH_KERNEL
+#endif
+
+// BatchWindow describes a 2^32-second window starting at midnight.
+typedef struct {
+    uint64_t start;  // window start as an absolute time
+    uint32_t cday;   // days since March 1 of a 400-year cycle at window start
+    int64_t year;    // computational year in which that 400-year cycle starts
+    uint32_t wday;   // weekday at window start
+} BatchWindow;
+
+// batch_window returns a window that is centered around the absolute time abs.
+static BatchWindow batch_window(uint64_t abs) {
+    const uint64_t half = (UINT64_C(1) << 31) / seconds_per_day;
+    uint64_t day = abs / seconds_per_day;
+    day = day > half ? day - half : 0;
+
+    // See abs_civil for the computational calendar.
+    uint64_t n = day + 306;
+    BatchWindow w;
+    w.start = day * seconds_per_day;
+    w.cday = n % days_per_400_years;
+    w.year = 400 * (n / days_per_400_years) + absolute_zero_year - 1;
+    w.wday = (day + TIME_MONDAY) % 7;
+    return w;
+}
+
+// batch_offsets stores the offsets of the time values from the window start,
+// and reports whether all of them fit into the window. Pads the offsets
+// with zeros up to BATCH_CHUNK, so the kernels always run a full chunk
+// (partial chunks go through a scratch buffer).
+static bool batch_offsets(const Time* in, size_t n, BatchWindow w, uint32_t* rel) {
+    uint64_t outside = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t off = abs_time(in[i]) - w.start;
+        rel[i] = (uint32_t)off;
+        outside |= off >> 32;
+    }
+    memset(rel + n, 0, (BATCH_CHUNK - n) * sizeof(rel[0]));
+    return outside == 0;
+}
+
+// batch_in_window reports whether the time value t fits into the window.
+static bool batch_in_window(Time t, BatchWindow w) {
+    return ((abs_time(t) - w.start) >> 32) == 0;
+}
+
+// date_kernel is the branch-free equivalent of abs_date_full
+// for a chunk of time values within a window.
+BATCH_KERNEL static void date_kernel(const uint32_t* restrict rel,
+                                     BatchWindow w,
+                                     int* restrict year,
+                                     int* restrict month,
+                                     int* restrict day) {
+    for (size_t i = 0; i < BATCH_CHUNK; i++) {
+        uint32_t cday = w.cday + rel[i] / 86400;
+        uint32_t n1 = 4 * cday + 3;
+        uint32_t century = n1 / 146097;
+        uint32_t ncen = n1 % 146097 / 4;
+        uint64_t p2 = UINT64_C(2939745) * (4 * ncen + 3);
+        uint32_t ycen = (uint32_t)(p2 >> 32);
+        uint32_t nyear = (uint32_t)p2 / 2939745 / 4;
+        uint32_t n3 = 2141 * nyear + 197913;
+        uint32_t jan_feb = nyear >= 306;
+        year[i] = (int)(w.year + 100 * century + ycen + jan_feb);
+        month[i] = (int)((n3 >> 16) - 12 * jan_feb);
+        day[i] = (int)((n3 & 0xFFFF) / 2141 + 1);
+    }
+}
+
+// clock_kernel is the branch-free equivalent of abs_clock
+// for a chunk of time values within a window.
+BATCH_KERNEL static void clock_kernel(const uint32_t* restrict rel,
+                                      int* restrict hour,
+                                      int* restrict min,
+                                      int* restrict sec) {
+    for (size_t i = 0; i < BATCH_CHUNK; i++) {
+        uint32_t s = rel[i] % 86400;
+        hour[i] = (int)(s / 3600);
+        min[i] = (int)(s % 3600 / 60);
+        sec[i] = (int)(s % 60);
+    }
+}
+
+// weekday_kernel is the branch-free equivalent of abs_weekday
+// for a chunk of time values within a window.
+BATCH_KERNEL static void weekday_kernel(const uint32_t* restrict rel,
+                                        BatchWindow w,
+                                        int* restrict weekday) {
+    for (size_t i = 0; i < BATCH_CHUNK; i++) {
+        weekday[i] = (int)((w.wday + rel[i] / 86400) % 7);
+    }
+}
+
+// date_chunk decomposes up to BATCH_CHUNK time values into dates.
+static void date_chunk(const Time* in, size_t n, int* year, int* month, int* day) {
+    uint32_t rel[BATCH_CHUNK];
+    BatchWindow w = batch_window(abs_time(in[0]));
+    bool inside = batch_offsets(in, n, w, rel);
+    if (n == BATCH_CHUNK) {
+        date_kernel(rel, w, year, month, day);
+    } else {
+        int y[BATCH_CHUNK], m[BATCH_CHUNK], d[BATCH_CHUNK];
+        date_kernel(rel, w, y, m, d);
+        memcpy(year, y, n * sizeof(int));
+        memcpy(month, m, n * sizeof(int));
+        memcpy(day, d, n * sizeof(int));
+    }
+    for (size_t i = 0; !inside && i < n; i++) {
+        if (!batch_in_window(in[i], w)) {
+            int yday;
+            enum Month mon;
+            abs_date_full(abs_time(in[i]), &year[i], &mon, &day[i], &yday);
+            month[i] = mon;
+        }
+    }
+}
+
+// clock_chunk decomposes up to BATCH_CHUNK time values into clocks.
+static void clock_chunk(const Time* in, size_t n, int* hour, int* min, int* sec) {
+    uint32_t rel[BATCH_CHUNK];
+    BatchWindow w = batch_window(abs_time(in[0]));
+    bool inside = batch_offsets(in, n, w, rel);
+    if (n == BATCH_CHUNK) {
+        clock_kernel(rel, hour, min, sec);
+    } else {
+        int h[BATCH_CHUNK], m[BATCH_CHUNK], s[BATCH_CHUNK];
+        clock_kernel(rel, h, m, s);
+        memcpy(hour, h, n * sizeof(int));
+        memcpy(min, m, n * sizeof(int));
+        memcpy(sec, s, n * sizeof(int));
+    }
+    for (size_t i = 0; !inside && i < n; i++) {
+        if (!batch_in_window(in[i], w)) {
+            abs_clock(abs_time(in[i]), &hour[i], &min[i], &sec[i]);
+        }
+    }
+}
+
+// weekday_chunk decomposes up to BATCH_CHUNK time values into weekdays.
+static void weekday_chunk(const Time* in, size_t n, int* weekday) {
+    uint32_t rel[BATCH_CHUNK];
+    BatchWindow w = batch_window(abs_time(in[0]));
+    bool inside = batch_offsets(in, n, w, rel);
+    if (n == BATCH_CHUNK) {
+        weekday_kernel(rel, w, weekday);
+    } else {
+        int wd[BATCH_CHUNK];
+        weekday_kernel(rel, w, wd);
+        memcpy(weekday, wd, n * sizeof(int));
+    }
+    for (size_t i = 0; !inside && i < n; i++) {
+        if (!batch_in_window(in[i], w)) {
+            weekday[i] = abs_weekday(abs_time(in[i]));
+        }
+    }
+}
+
+// time_get_date_batch returns the year, month, and day in which each
+// of the n time values occurs. Equivalent to calling time_get_date
+// for each element, but faster.
+void time_get_date_batch(const Time* in, size_t n, int* year, int* month, int* day) {
+    for (size_t i = 0; i < n; i += BATCH_CHUNK) {
+        size_t m = n - i < BATCH_CHUNK ? n - i : BATCH_CHUNK;
+        date_chunk(in + i, m, year + i, month + i, day + i);
+    }
+}
+
+// time_get_clock_batch returns the hour, minute, and second within the day
+// specified by each of the n time values. Equivalent to calling time_get_clock
+// for each element, but faster.
+void time_get_clock_batch(const Time* in, size_t n, int* hour, int* min, int* sec) {
+    for (size_t i = 0; i < n; i += BATCH_CHUNK) {
+        size_t m = n - i < BATCH_CHUNK ? n - i : BATCH_CHUNK;
+        clock_chunk(in + i, m, hour + i, min + i, sec + i);
+    }
+}
+
+// time_get_weekday_batch returns the day of the week specified by each
+// of the n time values. Equivalent to calling time_get_weekday
+// for each element, but faster.
+void time_get_weekday_batch(const Time* in, size_t n, int* weekday) {
+    for (size_t i = 0; i < n; i += BATCH_CHUNK) {
+        size_t m = n - i < BATCH_CHUNK ? n - i : BATCH_CHUNK;
+        weekday_chunk(in + i, m, weekday + i);
+    }
+}
+
+// ## Batch constructors
+
+// batch_zero_year starts a 400-year cycle (like the absolute zero year)
+// and precedes INT_MIN, so the batch constructor can count any int year
+// from it as an unsigned 32-bit number (up to batch_max_year).
+static const int64_t batch_zero_year = -2147483999LL;
+static const int64_t batch_max_year = 2147483295LL;
+
+// time_date_kernel is the branch-free equivalent of time_date for a chunk
+// of values that need no normalization. Stores the resulting seconds in secs
+// and marks the values that do need normalization in denorm.
+BATCH_KERNEL static void time_date_kernel(const int* restrict year,
+                                          const int* restrict month,
+                                          const int* restrict day,
+                                          const int* restrict hour,
+                                          const int* restrict min,
+                                          const int* restrict sec,
+                                          const int* restrict nsec,
+                                          const int* restrict offset_sec,
+                                          uint64_t base_days,
+                                          int64_t* restrict secs,
+                                          int* restrict denorm) {
+    for (size_t i = 0; i < BATCH_CHUNK; i++) {
+        // Days from the batch zero year to January 1 (see days_since_epoch).
+        uint32_t y = (uint32_t)(year[i] - batch_zero_year);
+        uint32_t c = y / 100;
+        uint64_t d = base_days + ((UINT64_C(1461) * y) >> 2) - c + (c >> 2);
+
+        // Days before the month, without the days_before table:
+        // (367*m - 362) / 12 assumes a 30-day February, so March and later
+        // months are corrected by -2 (or -1 in leap years).
+        uint32_t ly = y + 1;  // same as year modulo 400
+        uint32_t leap = (ly & 3) == 0 && (ly % 25 != 0 || (ly & 15) == 0);
+        uint32_t m = (uint32_t)month[i];
+        d += (367 * m - 362) / 12;
+        d -= (m > 2) * (2 - leap);
+
+        // Days before today, and time elapsed today.
+        d += (int64_t)day[i] - 1;
+        int64_t clock = (int64_t)hour[i] * 3600 + (int64_t)min[i] * 60 + sec[i] - offset_sec[i];
+        secs[i] = (int64_t)(d * 86400 + (uint64_t)clock + (uint64_t)absolute_to_internal);
+
+        // The day is not checked: like time_date, out-of-range days (0, -5, 40)
+        // just add linearly to the day count above, so they need no normalization.
+        denorm[i] = (m - 1 >= 12) | ((uint32_t)hour[i] >= 24) | ((uint32_t)min[i] >= 60) |
+                    ((uint32_t)sec[i] >= 60) | ((uint32_t)nsec[i] >= 1000000000) |
+                    (year[i] > batch_max_year);
+    }
+}
+
+// time_date_batch returns the Time values corresponding to n rows of
+// yyyy-mm-dd hh:mm:ss + nsec nanoseconds, given as separate columns.
+// Equivalent to calling time_date for each row, but faster.
+//
+// The hour, min, sec, and nsec columns may be NULL, meaning all zeros.
+// The offset_sec column may be NULL, meaning that all rows share
+// the same timezone offset shared_offset_sec.
+void time_date_batch(const int* year,
+                     const int* month,
+                     const int* day,
+                     const int* hour,
+                     const int* min,
+                     const int* sec,
+                     const int* nsec,
+                     const int* offset_sec,
+                     int shared_offset_sec,
+                     size_t n,
+                     Time* out) {
+    static const int zeros[BATCH_CHUNK] = {0};
+    int shared[BATCH_CHUNK];
+    for (size_t i = 0; i < BATCH_CHUNK; i++) {
+        shared[i] = shared_offset_sec;
+    }
+    uint64_t base_days = days_since_epoch(batch_zero_year);
+
+    size_t i = 0;
+    for (; i + BATCH_CHUNK <= n; i += BATCH_CHUNK) {
+        const int* h = hour ? hour + i : zeros;
+        const int* m = min ? min + i : zeros;
+        const int* s = sec ? sec + i : zeros;
+        const int* ns = nsec ? nsec + i : zeros;
+        const int* of = offset_sec ? offset_sec + i : shared;
+
+        int64_t secs[BATCH_CHUNK];
+        int denorm[BATCH_CHUNK];
+        time_date_kernel(year + i, month + i, day + i, h, m, s, ns, of, base_days, secs, denorm);
+        for (size_t k = 0; k < BATCH_CHUNK; k++) {
+            if (denorm[k]) {
+                out[i + k] = time_date(year[i + k], month[i + k], day[i + k], h[k], m[k], s[k],
+                                       ns[k], of[k]);
+            } else {
+                out[i + k] = (Time){secs[k], ns[k]};
+            }
+        }
+    }
+
+    // The remaining rows do not fill a chunk.
+    for (; i < n; i++) {
+        out[i] = time_date(year[i], month[i], day[i], hour ? hour[i] : 0, min ? min[i] : 0,
+                           sec ? sec[i] : 0, nsec ? nsec[i] : 0,
+                           offset_sec ? offset_sec[i] : shared_offset_sec);
+    }
 }
 
 // ## Unix time
@@ -568,17 +880,15 @@ Time time_tm(struct tm tm, int offset_sec) {
 // time_to_tm returns t in the given timezone offset as a calendar time.
 struct tm time_to_tm(Time t, int offset_sec) {
     Time loc_t = time_add(t, offset_sec * TIME_SECOND);
-    int year, day, hour, min, sec;
-    enum Month month;
-    time_get_date(loc_t, &year, &month, &day);
-    time_get_clock(loc_t, &hour, &min, &sec);
+    TimeFields f;
+    time_get_fields(loc_t, &f);
     struct tm tm = {
-        .tm_year = year - 1900,
-        .tm_mon = month - 1,
-        .tm_mday = day,
-        .tm_hour = hour,
-        .tm_min = min,
-        .tm_sec = sec,
+        .tm_year = f.year - 1900,
+        .tm_mon = f.month - 1,
+        .tm_mday = f.day,
+        .tm_hour = f.hour,
+        .tm_min = f.min,
+        .tm_sec = f.sec,
         .tm_isdst = -1,
     };
     return tm;
@@ -670,14 +980,31 @@ Duration time_until(Time t) {
 // so, for example, adding one month to October 31 yields
 // December 1, the normalized form for November 31.
 Time time_add_date(Time t, int years, int months, int days) {
-    int year, day;
+    uint64_t abs = abs_time(t);
+    int year, day, yday, hour, min, sec;
     enum Month month;
-    time_get_date(t, &year, &month, &day);
-    int hour, min, sec;
-    time_get_clock(t, &hour, &min, &sec);
+    abs_date_full(abs, &year, &month, &day, &yday);
+    abs_clock(abs, &hour, &min, &sec);
     return time_date(year + years, month + months, day + days, hour, min, sec, t.nsec, 0);
 }
 
+// time_add_period returns the time corresponding to adding the period p to t:
+// first the calendar part as time_add_date does, then the exact part
+// as time_add does. For example, adding P1MT1H to January 31, 2011 10:00
+// returns March 3, 2011 11:00.
+//
+// Decomposes t into date and time of day at most once. Periods
+// without years and months do not need it at all, because in UTC
+// every day is exactly 24 hours long.
+Time time_add_period(Time t, Period p) {
+    if (p.years != 0 || p.months != 0) {
+        t = time_add_date(t, p.years, p.months, p.days);
+    } else {
+        t.sec += (int64_t)p.days * seconds_per_day;
+    }
+    return time_add(t, p.duration);
+}
+
 // ## Rounding
 
 // time_truncate returns the result of rounding t down to a multiple of d (since
@@ -707,6 +1034,71 @@ Time time_round(Time t, Duration d) {
 
 // ## Marshaling
 
+// The big-endian helpers below use a plain load or store plus a byte swap
+// on little-endian GCC and Clang targets. GCC does not merge the separate
+// byte stores into one when they are interleaved in a loop, which makes
+// the batch functions twice as slow. Elsewhere, the helpers fall back
+// to assembling the bytes one by one.
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define HAS_BSWAP 1
+#else
+#define HAS_BSWAP 0
+#endif
+
+// put_be64 writes v at b in big-endian byte order.
+static inline void put_be64(uint8_t* b, uint64_t v) {
+#if HAS_BSWAP
+    v = __builtin_bswap64(v);
+    memcpy(b, &v, sizeof(v));
+#else
+    b[0] = (uint8_t)(v >> 56);
+    b[1] = (uint8_t)(v >> 48);
+    b[2] = (uint8_t)(v >> 40);
+    b[3] = (uint8_t)(v >> 32);
+    b[4] = (uint8_t)(v >> 24);
+    b[5] = (uint8_t)(v >> 16);
+    b[6] = (uint8_t)(v >> 8);
+    b[7] = (uint8_t)v;
+#endif
+}
+
+// put_be32 writes v at b in big-endian byte order.
+static inline void put_be32(uint8_t* b, uint32_t v) {
+#if HAS_BSWAP
+    v = __builtin_bswap32(v);
+    memcpy(b, &v, sizeof(v));
+#else
+    b[0] = (uint8_t)(v >> 24);
+    b[1] = (uint8_t)(v >> 16);
+    b[2] = (uint8_t)(v >> 8);
+    b[3] = (uint8_t)v;
+#endif
+}
+
+// get_be64 reads a big-endian value at b.
+static inline uint64_t get_be64(const uint8_t* b) {
+#if HAS_BSWAP
+    uint64_t v;
+    memcpy(&v, b, sizeof(v));
+    return __builtin_bswap64(v);
+#else
+    return (uint64_t)b[0] << 56 | (uint64_t)b[1] << 48 | (uint64_t)b[2] << 40 |
+           (uint64_t)b[3] << 32 | (uint64_t)b[4] << 24 | (uint64_t)b[5] << 16 |
+           (uint64_t)b[6] << 8 | (uint64_t)b[7];
+#endif
+}
+
+// get_be32 reads a big-endian value at b.
+static inline uint32_t get_be32(const uint8_t* b) {
+#if HAS_BSWAP
+    uint32_t v;
+    memcpy(&v, b, sizeof(v));
+    return __builtin_bswap32(v);
+#else
+    return (uint32_t)b[0] << 24 | (uint32_t)b[1] << 16 | (uint32_t)b[2] << 8 | (uint32_t)b[3];
+#endif
+}
+
 // time_unmarshal_binary returns the time instant represented by the binary data.
 // The blob must have been created by time_marshal_binary and be at least 13 bytes long.
 Time time_unmarshal_binary(const uint8_t* buf) {
@@ -714,15 +1106,7 @@ Time time_unmarshal_binary(const uint8_t* buf) {
     if (version != 1) {
         return (Time){0, 0};
     }
-
-    int64_t sec = (int64_t)buf[8] | (int64_t)buf[7] << 8 | (int64_t)buf[6] << 16 |
-                  (int64_t)buf[5] << 24 | (int64_t)buf[4] << 32 | (int64_t)buf[3] << 40 |
-                  (int64_t)buf[2] << 48 | (int64_t)buf[1] << 56;
-
-    int32_t nsec =
-        (int32_t)buf[12] | (int32_t)buf[11] << 8 | (int32_t)buf[10] << 16 | (int32_t)buf[9] << 24;
-
-    return (Time){sec, nsec};
+    return (Time){(int64_t)get_be64(buf + 1), (int32_t)get_be32(buf + 9)};
 }
 
 // time_marshal_binary returns the binary representation of the time instant t.
@@ -734,16 +1118,70 @@ Time time_unmarshal_binary(const uint8_t* buf) {
 void time_marshal_binary(Time t, uint8_t* buf) {
     const uint8_t version = 1;
     buf[0] = version;
-    buf[1] = t.sec >> 56;  // bytes 1-8: seconds
-    buf[2] = t.sec >> 48;
-    buf[3] = t.sec >> 40;
-    buf[4] = t.sec >> 32;
-    buf[5] = t.sec >> 24;
-    buf[6] = t.sec >> 16;
-    buf[7] = t.sec >> 8;
-    buf[8] = t.sec;
-    buf[9] = t.nsec >> 24;  // bytes 9-12: nanoseconds
-    buf[10] = t.nsec >> 16;
-    buf[11] = t.nsec >> 8;
-    buf[12] = t.nsec;
+    put_be64(buf + 1, (uint64_t)t.sec);   // bytes 1-8: seconds
+    put_be32(buf + 9, (uint32_t)t.nsec);  // bytes 9-12: nanoseconds
+}
+
+// time_marshal_binary_batch writes n time values as consecutive binary blobs,
+// in the same format as time_marshal_binary.
+// buf must be at least n * TIME_BINARY_SIZE bytes long.
+void time_marshal_binary_batch(const Time* in, size_t n, uint8_t* buf) {
+    for (size_t i = 0; i < n; i++, buf += TIME_BINARY_SIZE) {
+        Time t = in[i];
+        buf[0] = 1;
+        put_be64(buf + 1, (uint64_t)t.sec);
+        put_be32(buf + 9, (uint32_t)t.nsec);
+    }
+}
+
+// time_unmarshal_binary_batch reads n consecutive binary blobs created by
+// time_marshal_binary or time_marshal_binary_batch. Like time_unmarshal_binary,
+// returns the zero time for blobs with an unknown version.
+void time_unmarshal_binary_batch(const uint8_t* buf, size_t n, Time* out) {
+    for (size_t i = 0; i < n; i++, buf += TIME_BINARY_SIZE) {
+        Time t = {(int64_t)get_be64(buf + 1), (int32_t)get_be32(buf + 9)};
+        out[i] = buf[0] == 1 ? t : (Time){0, 0};
+    }
+}
+
+// key_sign_bit flips the sign of the seconds in a key, so that
+// negative seconds sort before positive ones as unsigned values.
+static const uint64_t key_sign_bit = (uint64_t)1 << 63;
+
+// time_marshal_key writes t as a key that sorts like t under memcmp:
+// for any t and u, memcmp of their keys has the same sign as time_compare(t, u).
+// This makes keys usable in byte-ordered stores without a custom comparator.
+// buf must be at least TIME_KEY_SIZE (12) bytes long.
+// The key has the following layout:
+// 0-7: seconds, big-endian, with the sign bit flipped
+// 8-11: nanoseconds, big-endian
+void time_marshal_key(Time t, uint8_t* buf) {
+    put_be64(buf, (uint64_t)t.sec ^ key_sign_bit);
+    put_be32(buf + 8, (uint32_t)t.nsec);
+}
+
+// time_unmarshal_key returns the time instant represented by the key.
+// The key must have been created by time_marshal_key and be at least 12 bytes long.
+Time time_unmarshal_key(const uint8_t* buf) {
+    return (Time){(int64_t)(get_be64(buf) ^ key_sign_bit), (int32_t)get_be32(buf + 8)};
+}
+
+// time_marshal_key_batch writes n time values as consecutive keys,
+// in the same format as time_marshal_key.
+// buf must be at least n * TIME_KEY_SIZE bytes long.
+void time_marshal_key_batch(const Time* in, size_t n, uint8_t* buf) {
+    for (size_t i = 0; i < n; i++, buf += TIME_KEY_SIZE) {
+        Time t = in[i];
+        put_be64(buf, (uint64_t)t.sec ^ key_sign_bit);
+        put_be32(buf + 8, (uint32_t)t.nsec);
+    }
+}
+
+// time_unmarshal_key_batch reads n consecutive keys created by
+// time_marshal_key or time_marshal_key_batch.
+void time_unmarshal_key_batch(const uint8_t* buf, size_t n, Time* out) {
+    for (size_t i = 0; i < n; i++, buf += TIME_KEY_SIZE) {
+        out[i].sec = (int64_t)(get_be64(buf) ^ key_sign_bit);
+        out[i].nsec = (int32_t)get_be32(buf + 8);
+    }
 }
@@ -52,12 +52,88 @@ typedef struct {
 } Time;
 
 #define TIME_BINARY_SIZE 13
+#define TIME_KEY_SIZE 12
+#define TIME_DOD_MAX_SIZE 15
+#define TIME_FOR_HEADER_SIZE 17
+
+// TimeFields holds the calendar and clock fields of a time instant.
+typedef struct {
+    int year;              // year
+    enum Month month;      // month of the year
+    int day;               // day of the month [1, 31]
+    int yday;              // day of the year [1, 366]
+    enum Weekday weekday;  // day of the week
+    int hour;              // hour within the day [0, 23]
+    int min;               // minute within the hour [0, 59]
+    int sec;               // second within the minute [0, 59]
+    int nsec;              // nanosecond within the second [0, 999999999]
+    int iso_year;          // ISO 8601 year
+    int iso_week;          // ISO 8601 week number [1, 53]
+} TimeFields;
+
+// TimeLayout is a Go-style layout compiled into a list of operations
+// by time_layout_compile. The fields are internal.
+#define TIME_LAYOUT_MAX_OPS 32
+#define TIME_LAYOUT_MAX_TEXT 64
+typedef struct {
+    uint8_t nops;                       // number of operations
+    uint8_t needs;                      // time parts used by the operations
+    uint16_t max_len;                   // maximum length of the formatted string
+    uint8_t ops[TIME_LAYOUT_MAX_OPS];   // operation codes
+    uint8_t args[TIME_LAYOUT_MAX_OPS];  // operation arguments
+    char text[TIME_LAYOUT_MAX_TEXT];    // literal text
+} TimeLayout;
+
+// TimeFmtCache holds the formatted date and time of day of the last second
+// formatted by time_fmt_iso_cached. A zero value is an empty cache.
+// The fields are internal. Not safe for concurrent use: use one cache per thread.
+typedef struct {
+    int64_t sec;         // cached second
+    int32_t offset_sec;  // cached timezone offset
+    uint8_t prefix_len;  // length of prefix, 0 if the cache is empty
+    uint8_t suffix_len;  // length of suffix
+    char prefix[32];     // date and time of day (2006-01-02T15:04:05)
+    char suffix[16];     // timezone (Z or +07:00)
+} TimeFmtCache;
+
+// TimeDodState holds the last value of a delta-of-delta compressed stream
+// (see time_dod_encode). A zero value starts a new stream. The fields are internal.
+typedef struct {
+    int64_t sec;    // seconds of the last value
+    int64_t delta;  // gap in seconds between the last two values
+    int32_t nsec;   // nanoseconds of the last value
+} TimeDodState;
+
+// TimeForBlock is an opened frame-of-reference block (see time_for_encode).
+typedef struct {
+    Time base;            // smallest value in the block
+    const uint8_t* data;  // bit-packed offsets from base in nanoseconds
+    uint32_t n;           // number of values
+    uint8_t width;        // bits per offset
+} TimeForBlock;
 
 // Duration represents the elapsed time between two instants
 // as an int64 nanosecond count. The representation limits the
 // largest representable duration to approximately 290 years.
 typedef int64_t Duration;
 
+// Period is an ISO 8601 duration such as P1Y2M3DT4H5M6S. The calendar part
+// (years, months and days) depends on the date it is applied to, so it is
+// kept apart from the exact part (a Duration).
+typedef struct {
+    int years;
+    int months;
+    int days;
+    Duration duration;
+} Period;
+
+// MonoTime is a reading of the monotonic clock: the number of nanoseconds
+// since an unspecified starting point. Monotonic readings are only
+// meaningful relative to other readings taken on the same system.
+typedef struct {
+    int64_t nsec;
+} MonoTime;
+
 // ## Time
 
 // ### Time constructors
@@ -65,6 +141,31 @@ typedef int64_t Duration;
 // time_now returns the current time in UTC.
 Time time_now(void);
 
+// time_now_coarse returns the current time in UTC with the resolution
+// of the system tick, which is cheaper to read than time_now.
+Time time_now_coarse(void);
+
+// time_clock_start starts a background thread that refreshes
+// the cached clock every interval. Returns false if the cached clock
+// is not supported on this platform.
+bool time_clock_start(Duration interval);
+
+// time_clock_stop stops the cached clock.
+void time_clock_stop(void);
+
+// time_now_cached returns the time of the latest cached clock tick,
+// or the current time if the cached clock is not running.
+Time time_now_cached(void);
+
+// time_tsc_init calibrates the TSC clock. Returns false if the CPU
+// lacks an invariant time stamp counter.
+bool time_tsc_init(void);
+
+// time_now_tsc returns the current time in UTC computed from the CPU
+// time stamp counter, or from the system clock if the TSC clock
+// is not available.
+Time time_now_tsc(void);
+
 // time_date returns the Time corresponding to
 // yyyy-mm-dd hh:mm:ss + nsec nanoseconds
 // with the given timezone offset in seconds.
@@ -77,6 +178,20 @@ Time time_date(int year,
                int nsec,
                int offset_sec);
 
+// time_date_batch returns the Time values corresponding to n rows of
+// yyyy-mm-dd hh:mm:ss + nsec nanoseconds, given as separate columns.
+void time_date_batch(const int* year,
+                     const int* month,
+                     const int* day,
+                     const int* hour,
+                     const int* min,
+                     const int* sec,
+                     const int* nsec,
+                     const int* offset_sec,
+                     int shared_offset_sec,
+                     size_t n,
+                     Time* out);
+
 // ### Time parts
 
 // time_get_date returns the year, month, and day in which t occurs.
@@ -115,6 +230,23 @@ int time_get_yearday(Time t);
 // time_get_isoweek returns the ISO 8601 year and week number in which t occurs.
 void time_get_isoweek(Time t, int* year, int* week);
 
+// time_get_fields returns all the calendar and clock fields of t at once.
+void time_get_fields(Time t, TimeFields* fields);
+
+// ### Batch time parts
+
+// time_get_date_batch returns the year, month, and day in which
+// each of the n time values occurs.
+void time_get_date_batch(const Time* in, size_t n, int* year, int* month, int* day);
+
+// time_get_clock_batch returns the hour, minute, and second within the day
+// specified by each of the n time values.
+void time_get_clock_batch(const Time* in, size_t n, int* hour, int* min, int* sec);
+
+// time_get_weekday_batch returns the day of the week specified by
+// each of the n time values.
+void time_get_weekday_batch(const Time* in, size_t n, int* weekday);
+
 // ### Unix time
 
 // time_unix returns the Time corresponding to the given Unix time,
@@ -194,6 +326,9 @@ Duration time_until(Time t);
 // given number of years, months, and days to t.
 Time time_add_date(Time t, int years, int months, int days);
 
+// time_add_period returns the time corresponding to adding the period p to t.
+Time time_add_period(Time t, Period p);
+
 // ### Time rounding
 
 // time_truncate returns the result of rounding t down to a multiple of d.
@@ -207,6 +342,36 @@ Time time_round(Time t, Duration d);
 // time_fmt_iso returns an ISO 8601 time string for the given time value.
 size_t time_fmt_iso(Time t, int offset_sec, char* buf, size_t size);
 
+// TIME_PREC_TRIM tells time_fmt_iso_prec to omit trailing zeros
+// in fractional seconds.
+#define TIME_PREC_TRIM -1
+
+// time_fmt_iso_prec returns an ISO 8601 time string for the given time value
+// with the given number of fractional second digits.
+size_t time_fmt_iso_prec(Time t, int offset_sec, int prec, char* buf, size_t size);
+
+// time_fmt_iso_batch writes n ISO 8601 time strings back to back into buf,
+// and their Arrow-style offsets into offsets (or at a fixed width if it is NULL).
+size_t time_fmt_iso_batch(const Time* in,
+                          size_t n,
+                          int offset_sec,
+                          int prec,
+                          char* buf,
+                          size_t size,
+                          int32_t* offsets);
+
+// time_fmt_iso_batch_size returns the number of bytes time_fmt_iso_batch writes.
+size_t time_fmt_iso_batch_size(const Time* in, size_t n, int offset_sec, int prec);
+
+// time_fmt_iso_cached is like time_fmt_iso_prec, but reuses the date and time
+// of day from the cache when t falls within the same second as the last call.
+size_t time_fmt_iso_cached(TimeFmtCache* cache,
+                           Time t,
+                           int offset_sec,
+                           int prec,
+                           char* buf,
+                           size_t size);
+
 // time_fmt_datetime returns a datetime string for the given time value.
 size_t time_fmt_datetime(Time t, int offset_sec, char* buf, size_t size);
 
@@ -216,9 +381,57 @@ size_t time_fmt_date(Time t, int offset_sec, char* buf, size_t size);
 // time_fmt_time returns a time string for the given time value.
 size_t time_fmt_time(Time t, int offset_sec, char* buf, size_t size);
 
+// time_layout_compile compiles a Go-style layout for use with time_fmt_layout.
+// Returns false if the layout is too long.
+bool time_layout_compile(const char* layout, TimeLayout* out);
+
+// time_fmt_layout returns a string for the given time value
+// formatted according to the compiled layout.
+size_t time_fmt_layout(Time t, int offset_sec, const TimeLayout* layout, char* buf, size_t size);
+
 // time_parse parses a formatted string and returns the time value it represents.
 Time time_parse(const char* value);
 
+// time_parse_n parses a time value at the beginning of a buffer of len bytes
+// and returns the number of bytes consumed (0 on failure).
+size_t time_parse_n(const char* s, size_t len, Time* out);
+
+// time_parse_layout parses a time value at the beginning of a buffer of len bytes
+// according to the compiled layout, and returns the number of bytes consumed
+// (0 on failure, with the position of the error in *err_pos).
+size_t time_parse_layout(const char* s,
+                         size_t len,
+                         const TimeLayout* layout,
+                         Time* out,
+                         size_t* err_pos);
+
+// time_parse_batch parses n strings given as pointers and lengths, and sets
+// the bits of the valid bitmap for the rows that parsed (returns their count).
+size_t time_parse_batch(const char* const* strs,
+                        const size_t* lens,
+                        size_t n,
+                        Time* out,
+                        uint8_t* valid);
+
+// time_parse_batch_offsets is like time_parse_batch, but takes an Arrow-style
+// string column: a contiguous data buffer plus n+1 offsets.
+size_t time_parse_batch_offsets(const char* data,
+                                const int32_t* offsets,
+                                size_t n,
+                                Time* out,
+                                uint8_t* valid);
+
+// time_fmt_http returns an HTTP date string (Sun, 06 Nov 1994 08:49:37 GMT).
+size_t time_fmt_http(Time t, char* buf, size_t size);
+
+// time_fmt_http_cached is like time_fmt_http, but formats the date at most
+// once per second, sharing the result between threads.
+size_t time_fmt_http_cached(Time t, char* buf, size_t size);
+
+// time_parse_http parses an HTTP date in any of the formats allowed by RFC 7231
+// and returns the number of bytes consumed (0 on failure).
+size_t time_parse_http(const char* s, size_t len, Time* out);
+
 // ### Time marshaling
 
 // time_unmarshal_binary returns the time instant represented by the binary data.
@@ -227,6 +440,47 @@ Time time_unmarshal_binary(const uint8_t* buf);
 // time_marshal_binary returns the binary representation of the time instant t.
 void time_marshal_binary(Time t, uint8_t* buf);
 
+// time_marshal_binary_batch writes n time values as consecutive binary blobs.
+void time_marshal_binary_batch(const Time* in, size_t n, uint8_t* buf);
+
+// time_unmarshal_binary_batch reads n consecutive binary blobs.
+void time_unmarshal_binary_batch(const uint8_t* buf, size_t n, Time* out);
+
+// time_marshal_key writes t as a 12-byte key that sorts like t under memcmp.
+void time_marshal_key(Time t, uint8_t* buf);
+
+// time_unmarshal_key returns the time instant represented by a key.
+Time time_unmarshal_key(const uint8_t* buf);
+
+// time_marshal_key_batch writes n time values as consecutive 12-byte keys.
+void time_marshal_key_batch(const Time* in, size_t n, uint8_t* buf);
+
+// time_unmarshal_key_batch reads n consecutive 12-byte keys.
+void time_unmarshal_key_batch(const uint8_t* buf, size_t n, Time* out);
+
+// ### Time compression
+
+// time_dod_encode compresses n time values using delta-of-delta encoding
+// and returns the number of bytes written (0 if buf is too small or n == 0).
+size_t time_dod_encode(TimeDodState* state, const Time* in, size_t n, uint8_t* buf, size_t size);
+
+// time_dod_decode decompresses n time values encoded by time_dod_encode
+// and returns the number of bytes consumed (0 if the data is malformed or n == 0).
+size_t time_dod_decode(TimeDodState* state, const uint8_t* buf, size_t len, Time* out, size_t n);
+
+// time_for_encode compresses n time values into a frame-of-reference block
+// with O(1) access to any value, and returns the number of bytes written.
+size_t time_for_encode(const Time* in, size_t n, uint8_t* buf, size_t size);
+
+// time_for_open checks a frame-of-reference block and prepares it for reading.
+bool time_for_open(const uint8_t* buf, size_t len, TimeForBlock* block);
+
+// time_for_get returns value k of the block.
+Time time_for_get(const TimeForBlock* block, size_t k);
+
+// time_for_decode decompresses all values of the block.
+void time_for_decode(const TimeForBlock* block, Time* out);
+
 // ## Duration
 
 // Min/Max durations.
@@ -270,4 +524,39 @@ Duration duration_round(Duration d, Duration m);
 // duration_abs returns the absolute value of d.
 Duration duration_abs(Duration d);
 
+// ### Duration formatting and parsing
+
+// duration_fmt returns a string representing the duration in the form "72h3m0.5s".
+size_t duration_fmt(Duration d, char* buf, size_t size);
+
+// duration_parse parses a duration string such as "300ms", "-1.5h" or "2h45m"
+// at the beginning of a buffer of len bytes. Returns the number of bytes consumed.
+size_t duration_parse(const char* s, size_t len, Duration* out);
+
+// ### ISO 8601 durations
+
+// period_fmt returns an ISO 8601 duration string such as "P1Y2M3DT4H5M6.5S".
+size_t period_fmt(Period p, char* buf, size_t size);
+
+// period_parse parses an ISO 8601 duration string such as "P1Y2M3DT4H5M6.5S"
+// at the beginning of a buffer of len bytes. Returns the number of bytes consumed.
+size_t period_parse(const char* s, size_t len, Period* out);
+
+// ## Monotonic time
+
+// time_mono_now returns the current reading of the monotonic clock.
+MonoTime time_mono_now(void);
+
+// time_mono_add returns the monotonic reading t+d (saturating on overflow).
+MonoTime time_mono_add(MonoTime t, Duration d);
+
+// time_mono_sub returns the duration t-u (saturating on overflow).
+Duration time_mono_sub(MonoTime t, MonoTime u);
+
+// time_mono_since returns the time elapsed since t.
+Duration time_mono_since(MonoTime t);
+
+// time_mono_until returns the duration until t.
+Duration time_mono_until(MonoTime t);
+
 #endif /* VAQT_H */
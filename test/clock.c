@@ -0,0 +1,190 @@
+// Copyright 2025 Anton Zhiyanov, BSD 3-Clause License
+// https://github.com/nalgeon/vaqt
+
+// Clock source tests.
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "vaqt.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <pthread.h>
+#endif
+
+// between reports whether t is within [start - slack, end].
+static bool between(Time t, Time start, Time end, Duration slack) {
+    return !time_before(t, time_add(start, -slack)) && !time_after(t, end);
+}
+
+static void test_now_coarse(void) {
+    printf("test_now_coarse...");
+    for (int i = 0; i < 1000; i++) {
+        Time start = time_now();
+        Time t = time_now_coarse();
+        Time end = time_now();
+        // The coarse clock lags behind by at most a system tick.
+        assert(between(t, start, end, 50 * TIME_MILLI));
+    }
+    printf("OK\n");
+}
+
+static void test_now_cached(void) {
+    printf("test_now_cached...");
+
+    // Not running: falls back to the current time.
+    Time start = time_now();
+    Time t = time_now_cached();
+    assert(between(t, start, time_now(), 0));
+
+    Duration interval = TIME_MILLI;
+    assert(time_clock_start(interval));
+    assert(time_clock_start(interval));  // already running
+
+    // Running: lags behind by about the tick interval.
+    start = time_now();
+    Time first = time_now_cached();
+    assert(between(first, start, time_now(), 50 * interval));
+
+    // The ticker keeps the cache fresh.
+    Time last = first;
+    while (time_equal(last, first) && time_since(start) < TIME_SECOND) {
+        last = time_now_cached();
+    }
+    assert(time_after(last, first));
+
+    time_clock_stop();
+    time_clock_stop();  // already stopped
+
+    // Stopped: falls back to the current time again.
+    start = time_now();
+    t = time_now_cached();
+    assert(between(t, start, time_now(), 0));
+
+    // Can be restarted.
+    assert(time_clock_start(interval));
+    time_clock_stop();
+
+    printf("OK\n");
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+// clock_start_stop starts and stops the cached clock over and over.
+static void* clock_start_stop(void* arg) {
+    (void)arg;
+    for (int i = 0; i < 100; i++) {
+        // Waits for any start or stop in progress, then reports it running.
+        assert(time_clock_start(TIME_MILLI));
+        time_now_cached();
+        time_clock_stop();
+    }
+    return NULL;
+}
+
+static void test_clock_concurrent(void) {
+    printf("test_clock_concurrent...");
+    enum { nthreads = 8 };
+    pthread_t threads[nthreads];
+    for (int i = 0; i < nthreads; i++) {
+        assert(pthread_create(&threads[i], NULL, clock_start_stop, NULL) == 0);
+    }
+    for (int i = 0; i < nthreads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    // Whatever the interleaving, the clock can be stopped and restarted.
+    time_clock_stop();
+    Time start = time_now();
+    Time t = time_now_cached();
+    assert(between(t, start, time_now(), 0));
+    assert(time_clock_start(TIME_MILLI));
+    time_clock_stop();
+    printf("OK\n");
+}
+#endif
+
+static void test_mono_now(void) {
+    printf("test_mono_now...");
+    MonoTime prev = time_mono_now();
+    for (int i = 0; i < 100000; i++) {
+        MonoTime t = time_mono_now();
+        assert(time_mono_sub(t, prev) >= 0);
+        prev = t;
+    }
+    // The monotonic clock advances at the same rate as the wall clock.
+    Time wall = time_now();
+    MonoTime mono = time_mono_now();
+    while (time_since(wall) < 10 * TIME_MILLI) {
+    }
+    Duration elapsed = time_mono_since(mono);
+    assert(elapsed >= 5 * TIME_MILLI && elapsed < TIME_SECOND);
+    printf("OK\n");
+}
+
+static void test_mono_arithmetic(void) {
+    printf("test_mono_arithmetic...");
+    MonoTime t = {1000};
+    MonoTime u = time_mono_add(t, 5 * TIME_SECOND);
+    assert(u.nsec == 1000 + 5 * TIME_SECOND);
+    assert(time_mono_sub(u, t) == 5 * TIME_SECOND);
+    assert(time_mono_sub(t, u) == -5 * TIME_SECOND);
+
+    // Out of range results saturate.
+    MonoTime max = {INT64_MAX}, min = {INT64_MIN};
+    assert(time_mono_add(t, DURATION_MAX).nsec == INT64_MAX);
+    assert(time_mono_add(max, 1).nsec == INT64_MAX);
+    assert(time_mono_add(max, DURATION_MIN).nsec == -1);
+    assert(time_mono_add((MonoTime){-1000}, DURATION_MIN).nsec == INT64_MIN);
+    assert(time_mono_add(min, -1).nsec == INT64_MIN);
+    assert(time_mono_sub(max, min) == DURATION_MAX);
+    assert(time_mono_sub(min, max) == DURATION_MIN);
+    assert(time_mono_sub(min, t) == DURATION_MIN);
+    assert(time_mono_sub((MonoTime){-1}, min) == DURATION_MAX);
+    assert(time_mono_sub(min, min) == 0);
+
+    MonoTime start = time_mono_now();
+    assert(time_mono_since(start) >= 0);
+    MonoTime deadline = time_mono_add(start, TIME_HOUR);
+    Duration left = time_mono_until(deadline);
+    assert(left > 59 * TIME_MINUTE && left <= TIME_HOUR);
+    assert(time_mono_until(start) <= 0);
+    printf("OK\n");
+}
+
+static void test_now_tsc(void) {
+    printf("test_now_tsc...");
+    if (!time_tsc_init()) {
+        // No invariant TSC: falls back to the current time.
+        Time start = time_now();
+        assert(between(time_now_tsc(), start, time_now(), 0));
+        printf("SKIP\n");
+        return;
+    }
+    assert(time_tsc_init());  // already calibrated
+
+    // Stays close to the system clock, including across recalibrations.
+    Time start = time_now();
+    Time prev = time_now_tsc();
+    while (time_since(start) < 1500 * TIME_MILLI) {
+        Time before = time_now();
+        Time t = time_now_tsc();
+        Time after = time_now();
+        assert(between(t, time_add(before, -TIME_MILLI), time_add(after, TIME_MILLI), 0));
+        assert(!time_before(t, time_add(prev, -TIME_MILLI)));
+        prev = t;
+    }
+    printf("OK\n");
+}
+
+int main(void) {
+    test_now_coarse();
+    test_now_cached();
+#if defined(__unix__) || defined(__APPLE__)
+    test_clock_concurrent();
+#endif
+    test_mono_now();
+    test_mono_arithmetic();
+    test_now_tsc();
+}
@@ -0,0 +1,327 @@
+// Copyright 2025 Anton Zhiyanov, BSD 3-Clause License
+// https://github.com/nalgeon/vaqt
+
+// Time compression tests.
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "vaqt.h"
+
+#define N 1000
+
+// rng_state is the state of the xorshift random number generator.
+static uint64_t rng_state = 88172645463325252ULL;
+
+// rng returns the next pseudo-random number (deterministic across runs).
+static uint64_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static Time series[N];
+static Time decoded[N];
+static uint8_t buf[N * TIME_DOD_MAX_SIZE];
+static uint8_t block_buf[TIME_FOR_HEADER_SIZE + 8 * (N + 1)];
+
+// fill_regular fills the series with values every 10 seconds.
+static void fill_regular(void) {
+    Time t = time_date(2025, TIME_JANUARY, 1, 0, 0, 0, 0, 0);
+    for (int i = 0; i < N; i++) {
+        series[i] = time_add(t, i * 10 * TIME_SECOND);
+    }
+}
+
+// fill_jitter fills the series with values about every 10 seconds,
+// with up to a millisecond of jitter.
+static void fill_jitter(void) {
+    Time t = time_date(2025, TIME_JANUARY, 1, 0, 0, 0, 0, 0);
+    for (int i = 0; i < N; i++) {
+        Duration jitter = (Duration)(rng() % 2000000) - 1000000;
+        series[i] = time_add(t, i * 10 * TIME_SECOND + jitter);
+    }
+}
+
+// fill_bursts fills the series with bursts of values nanoseconds apart.
+static void fill_bursts(void) {
+    Time t = time_date(2025, TIME_JANUARY, 1, 9, 30, 0, 0, 0);
+    for (int i = 0; i < N; i++) {
+        uint64_t max_gap = i % 100 == 0 ? 10 * (uint64_t)TIME_SECOND : 5000;
+        t = time_add(t, (Duration)(rng() % max_gap));
+        series[i] = t;
+    }
+}
+
+// fill_random fills the series with arbitrary values, including extreme ones.
+static void fill_random(void) {
+    for (int i = 0; i < N; i++) {
+        series[i] = (Time){(int64_t)rng(), (int32_t)(rng() % 1000000000)};
+    }
+    series[0] = (Time){INT64_MIN, 0};
+    series[1] = (Time){INT64_MAX, 999999999};
+    series[2] = (Time){INT64_MIN, 999999999};
+    series[3] = (Time){0, 0};
+}
+
+// roundtrip encodes and decodes the series, and returns the encoded size.
+static size_t roundtrip(void) {
+    TimeDodState enc = {0};
+    size_t size = time_dod_encode(&enc, series, N, buf, sizeof(buf));
+    assert(size > 0);
+
+    TimeDodState dec = {0};
+    memset(decoded, 0, sizeof(decoded));
+    assert(time_dod_decode(&dec, buf, size, decoded, N) == size);
+    for (int i = 0; i < N; i++) {
+        assert(time_equal(decoded[i], series[i]));
+    }
+    assert(memcmp(&enc, &dec, sizeof(enc)) == 0);
+    return size;
+}
+
+static void test_dod_roundtrip(void) {
+    printf("test_dod_roundtrip...");
+
+    // A regular series takes one byte per value (after the first one).
+    fill_regular();
+    size_t size = roundtrip();
+    assert(size < N + TIME_DOD_MAX_SIZE);
+    assert(size * 10 < N * TIME_BINARY_SIZE);
+
+    fill_jitter();
+    size = roundtrip();
+    assert(size < N * TIME_BINARY_SIZE / 2);
+
+    fill_bursts();
+    size = roundtrip();
+    assert(size < N * TIME_BINARY_SIZE / 2);
+
+    fill_random();
+    size = roundtrip();
+    assert(size <= N * TIME_DOD_MAX_SIZE);
+    printf("OK\n");
+}
+
+static void test_dod_stream(void) {
+    printf("test_dod_stream...");
+    fill_bursts();
+    TimeDodState enc = {0};
+    size_t size = time_dod_encode(&enc, series, N, buf, sizeof(buf));
+
+    // Encoding in chunks produces the same stream.
+    static uint8_t chunked[sizeof(buf)];
+    TimeDodState st = {0};
+    size_t w = 0;
+    for (size_t i = 0, k = 1; i < N; i += k, k = k * 2 + 1) {
+        size_t m = i + k <= N ? k : N - i;
+        w += time_dod_encode(&st, series + i, m, chunked + w, sizeof(chunked) - w);
+    }
+    assert(w == size);
+    assert(memcmp(chunked, buf, size) == 0);
+
+    // Decoding in chunks too.
+    st = (TimeDodState){0};
+    size_t r = 0;
+    for (size_t i = 0, k = 1; i < N; i += k, k = k * 3 + 1) {
+        size_t m = i + k <= N ? k : N - i;
+        r += time_dod_decode(&st, buf + r, size - r, decoded + i, m);
+    }
+    assert(r == size);
+    for (int i = 0; i < N; i++) {
+        assert(time_equal(decoded[i], series[i]));
+    }
+
+    // Nothing to encode or decode.
+    st = (TimeDodState){0};
+    assert(time_dod_encode(&st, series, 0, buf, sizeof(buf)) == 0);
+    assert(time_dod_decode(&st, buf, size, decoded, 0) == 0);
+    printf("OK\n");
+}
+
+static void test_dod_errors(void) {
+    printf("test_dod_errors...");
+    fill_random();
+    TimeDodState enc = {0};
+    size_t size = time_dod_encode(&enc, series, 10, buf, sizeof(buf));
+    assert(size > 0);
+
+    // Buffer too small: fails and leaves the state unchanged.
+    for (size_t n = 0; n < size; n++) {
+        TimeDodState st = {0};
+        assert(time_dod_encode(&st, series, 10, buf, n) == 0);
+        assert(st.sec == 0 && st.delta == 0 && st.nsec == 0);
+    }
+
+    // Truncated data: fails and leaves the state unchanged.
+    for (size_t n = 0; n < size; n++) {
+        TimeDodState st = {0};
+        assert(time_dod_decode(&st, buf, n, decoded, 10) == 0);
+        assert(st.sec == 0 && st.delta == 0 && st.nsec == 0);
+    }
+
+    // Varints that are too long.
+    uint8_t bad[32];
+    memset(bad, 0xff, sizeof(bad));
+    TimeDodState st = {0};
+    assert(time_dod_decode(&st, bad, sizeof(bad), decoded, 1) == 0);
+    bad[0] = 0x01;  // nsec delta follows
+    assert(time_dod_decode(&st, bad, sizeof(bad), decoded, 1) == 0);
+
+    // High bits of the delta-of-delta beyond 64 bits.
+    bad[0] = 0x80;  // high bits follow
+    memset(bad + 1, 0xff, 8);
+    bad[9] = 0x07;  // bits 56-58 of the high part
+    assert(time_dod_decode(&st, bad, 10, decoded, 1) == 0);
+    bad[9] = 0x03;  // bits 56-57: fits in 64 bits
+    assert(time_dod_decode(&st, bad, 10, decoded, 1) == 10);
+    st = (TimeDodState){0};
+
+    // No values is not an error.
+    assert(time_dod_encode(&st, series, 0, buf, sizeof(buf)) == 0);
+    assert(time_dod_decode(&st, buf, size, decoded, 0) == 0);
+
+    // Nanoseconds out of range.
+    bad[0] = 0x01;
+    bad[1] = 0x01;  // nsec delta -1
+    assert(time_dod_decode(&st, bad, 2, decoded, 1) == 0);
+    bad[1] = 0x02;  // nsec delta +1
+    assert(time_dod_decode(&st, bad, 2, decoded, 1) == 2);
+    assert(decoded[0].sec == 0 && decoded[0].nsec == 1);
+    printf("OK\n");
+}
+
+// for_roundtrip encodes the first n values of the series into a block,
+// checks that both random access and decoding return the original values,
+// and returns the block size.
+static size_t for_roundtrip(size_t n) {
+    size_t size = time_for_encode(series, n, block_buf, sizeof(block_buf));
+    assert(size > 0);
+    TimeForBlock block;
+    assert(time_for_open(block_buf, size, &block));
+    assert(block.n == n);
+
+    for (size_t i = 0; i < n; i++) {
+        assert(time_equal(time_for_get(&block, i), series[i]));
+    }
+    memset(decoded, 0, sizeof(decoded));
+    time_for_decode(&block, decoded);
+    for (size_t i = 0; i < n; i++) {
+        assert(time_equal(decoded[i], series[i]));
+    }
+    return size;
+}
+
+static void test_for_roundtrip(void) {
+    printf("test_for_roundtrip...");
+
+    // 10-second steps over 10000 seconds need 44 bits per value.
+    fill_regular();
+    size_t size = for_roundtrip(N);
+    assert(size == TIME_FOR_HEADER_SIZE + (N * 44 + 7) / 8 + 8);
+
+    fill_jitter();
+    for_roundtrip(N);
+    fill_bursts();
+    for_roundtrip(N);
+
+    // Unsorted values.
+    fill_bursts();
+    for (int i = 0; i < N; i += 2) {
+        Time tmp = series[i];
+        series[i] = series[N - 1 - i];
+        series[N - 1 - i] = tmp;
+    }
+    for_roundtrip(N);
+
+    // Every width, up to the largest span.
+    uint64_t max_off = 9223372035000000000ULL;
+    for (int width = 0; width <= 63; width++) {
+        Time base = {-1000, 999999999};
+        uint64_t top = ((uint64_t)1 << width) - 1;
+        top = top < max_off ? top : max_off;
+        for (int i = 0; i < N; i++) {
+            uint64_t off = width == 0 ? 0 : (rng() >> (64 - width)) % (top + 1);
+            series[i] = time_add(base, (Duration)off);
+        }
+        series[N / 2] = time_add(base, (Duration)top);
+        series[N / 3] = base;
+        size = for_roundtrip(N);
+        TimeForBlock block;
+        assert(time_for_open(block_buf, size, &block));
+        assert(block.width == width);
+    }
+
+    // Equal values take no space.
+    for (int i = 0; i < N; i++) {
+        series[i] = (Time){INT64_MIN, 5};
+    }
+    assert(for_roundtrip(N) == TIME_FOR_HEADER_SIZE + 8);
+
+    // Extreme values.
+    series[0] = (Time){INT64_MAX - 9223372035, 999999999};
+    series[1] = (Time){INT64_MAX, 999999999};
+    for_roundtrip(2);
+
+    // Single value and no values.
+    for_roundtrip(1);
+    for_roundtrip(0);
+    printf("OK\n");
+}
+
+static void test_for_errors(void) {
+    printf("test_for_errors...");
+
+    // The span is too large.
+    series[0] = (Time){0, 0};
+    series[1] = (Time){9223372036, 0};
+    assert(time_for_encode(series, 2, block_buf, sizeof(block_buf)) == 0);
+    series[0] = (Time){INT64_MIN, 0};
+    series[1] = (Time){INT64_MAX, 0};
+    assert(time_for_encode(series, 2, block_buf, sizeof(block_buf)) == 0);
+
+    // Buffer too small.
+    fill_jitter();
+    size_t size = time_for_encode(series, 10, block_buf, sizeof(block_buf));
+    assert(size > 0);
+    for (size_t n = 0; n < size; n++) {
+        assert(time_for_encode(series, 10, block_buf, n) == 0);
+    }
+
+    // Truncated or malformed block.
+    size = time_for_encode(series, 10, block_buf, sizeof(block_buf));
+    TimeForBlock block;
+    for (size_t n = 0; n < size; n++) {
+        assert(!time_for_open(block_buf, n, &block));
+    }
+    block_buf[16] = 64;  // width
+    assert(!time_for_open(block_buf, size, &block));
+    block_buf[16] = 44;
+    block_buf[11] = 0x80;  // negative nanoseconds
+    assert(!time_for_open(block_buf, size, &block));
+
+    // Base so large that the offsets overflow it: the values are
+    // meaningless, but reading them must not overflow.
+    series[0] = (Time){INT64_MAX - 5, 0};
+    series[1] = series[0];
+    size = time_for_encode(series, 2, block_buf, sizeof(block_buf));
+    block_buf[16] = 63;                // width
+    memset(block_buf + 17, 0xff, 16);  // all-ones offsets
+    assert(time_for_open(block_buf, size + 16, &block));
+    Time t = time_for_get(&block, 1);
+    assert(t.nsec >= 0 && t.nsec <= 999999999);
+    time_for_decode(&block, decoded);
+    printf("OK\n");
+}
+
+int main(void) {
+    test_dod_roundtrip();
+    test_dod_stream();
+    test_dod_errors();
+    test_for_roundtrip();
+    test_for_errors();
+}
@@ -240,6 +240,357 @@ static void test_abs(void) {
     printf("OK\n");
 }
 
+typedef struct {
+    const char* str;
+    Duration d;
+} FmtTest;
+
+static FmtTest fmt_tests[] = {
+    {"0s", 0},
+    {"1ns", 1},
+    {"1.1\xc2\xb5s", 1100},
+    {"2.2ms", 2200000},
+    {"3.3s", 3300000000},
+    {"4m5s", 245000000000},
+    {"4m5.001s", 245001000000},
+    {"5h6m7.001s", 18367001000000},
+    {"8m0.000000001s", 480000000001},
+    {"2562047h47m16.854775807s", DURATION_MAX},
+    {"-2562047h47m16.854775808s", DURATION_MIN},
+};
+
+static void test_fmt(void) {
+    printf("test_fmt...");
+    char buf[64];
+    for (size_t i = 0; i < sizeof(fmt_tests) / sizeof(fmt_tests[0]); i++) {
+        FmtTest test = fmt_tests[i];
+        size_t n = duration_fmt(test.d, buf, sizeof(buf));
+        // printf("want %s, got %s\n", test.str, buf);
+        assert(n == strlen(test.str));
+        assert(strcmp(buf, test.str) == 0);
+        if (test.d != 0 && test.d != DURATION_MIN) {
+            // The negative of a duration formats with a leading minus sign.
+            n = duration_fmt(-test.d, buf, sizeof(buf));
+            assert(n == strlen(test.str) + 1);
+            assert(buf[0] == '-' && strcmp(buf + 1, test.str) == 0);
+        }
+    }
+
+    // Truncates to fit the buffer, but returns the full length.
+    size_t n = duration_fmt(5 * TIME_HOUR + 6 * TIME_MINUTE, buf, 4);
+    assert(n == 6);
+    assert(strcmp(buf, "5h6") == 0);
+    assert(duration_fmt(TIME_SECOND, buf, 1) == 2);
+    assert(buf[0] == '\0');
+    assert(duration_fmt(TIME_SECOND, NULL, 0) == 2);
+    printf("OK\n");
+}
+
+typedef struct {
+    const char* in;
+    Duration want;
+} ParseTest;
+
+static ParseTest parse_tests[] = {
+    // simple
+    {"0", 0},
+    {"5s", 5000000000},
+    {"30s", 30000000000},
+    {"1478s", 1478000000000},
+    // sign
+    {"-5s", -5000000000},
+    {"+5s", 5000000000},
+    {"-0", 0},
+    {"+0", 0},
+    // decimal
+    {"5.0s", 5000000000},
+    {"5.6s", 5600000000},
+    {"5.s", 5000000000},
+    {".5s", 500000000},
+    {"1.0s", 1000000000},
+    {"1.00s", 1000000000},
+    {"1.004s", 1004000000},
+    {"1.0040s", 1004000000},
+    {"100.00100s", 100001000000},
+    // different units
+    {"10ns", 10},
+    {"11us", 11000},
+    {"12\xc2\xb5s", 12000},  // U+00B5
+    {"12\xce\xbcs", 12000},  // U+03BC
+    {"13ms", 13000000},
+    {"14s", 14000000000},
+    {"15m", 900000000000},
+    {"16h", 57600000000000},
+    // composite durations
+    {"3h30m", 12600000000000},
+    {"10.5s4m", 250500000000},
+    {"-2m3.4s", -123400000000},
+    {"1h2m3s4ms5us6ns", 3723004005006},
+    {"39h9m14.425s", 140954425000000},
+    // large value
+    {"52763797000ns", 52763797000},
+    // more than 9 digits after decimal point, see https://golang.org/issue/6617
+    {"0.3333333333333333333h", 1199999999999},
+    // 9007199254740993 = 1<<53+1 cannot be stored precisely in a float64
+    {"9007199254740993ns", 9007199254740993},
+    // largest duration that can be represented by int64 in nanoseconds
+    {"9223372036854775807ns", DURATION_MAX},
+    {"9223372036854775.807us", DURATION_MAX},
+    {"9223372036s854ms775us807ns", DURATION_MAX},
+    {"-9223372036854775808ns", DURATION_MIN},
+    {"-9223372036854775.808us", DURATION_MIN},
+    {"-9223372036s854ms775us808ns", DURATION_MIN},
+    {"-2562047h47m16.854775808s", DURATION_MIN},
+    // largest negative value
+    {"-9223372036854775808ns", DURATION_MIN},
+    // huge string, see https://golang.org/issue/15011
+    {"0.100000000000000000000h", 360000000000},
+    // fraction digits that overflow 64 bits
+    {"0.830103483285477580700h", 2988372539827},
+};
+
+static const char* parse_errors[] = {
+    // invalid
+    "",
+    "3",
+    "-",
+    "s",
+    ".",
+    "-.",
+    ".s",
+    "+.s",
+    "1d",
+    "1.5",
+    "1h.",
+    "00",
+    "1H",
+    "\x85\x85",
+    "\xff" "ff",
+    "hello \xff" "ff world",
+    // overflow
+    "9223372036854775810ns",
+    "9223372036854775808ns",
+    "9223372036854775.808us",
+    "-9223372036854775809ns",
+    "9223372036854ms775us808ns",
+    "2562047h47m16.854775808s",
+    "3000000h",
+    "9223372036854775807h",
+};
+
+static void test_parse(void) {
+    printf("test_parse...");
+    for (size_t i = 0; i < sizeof(parse_tests) / sizeof(parse_tests[0]); i++) {
+        ParseTest test = parse_tests[i];
+        Duration got = -1;
+        size_t n = duration_parse(test.in, strlen(test.in), &got);
+        // printf("%s: want %lld, got %lld\n", test.in, test.want, got);
+        assert(n == strlen(test.in));
+        assert(got == test.want);
+    }
+    for (size_t i = 0; i < sizeof(parse_errors) / sizeof(parse_errors[0]); i++) {
+        const char* in = parse_errors[i];
+        Duration got = 42;
+        assert(duration_parse(in, strlen(in), &got) == 0);
+        assert(got == 42);  // unchanged
+    }
+
+    // Round-trips formatted values.
+    char buf[32];
+    for (size_t i = 0; i < sizeof(fmt_tests) / sizeof(fmt_tests[0]); i++) {
+        Duration got = -1;
+        size_t n = duration_fmt(fmt_tests[i].d, buf, sizeof(buf));
+        assert(duration_parse(buf, n, &got) == n);
+        assert(got == fmt_tests[i].d);
+    }
+
+    // Parses a prefix of the buffer.
+    Duration got = 0;
+    const char* s = "1h30m, 5s";
+    assert(duration_parse(s, strlen(s), &got) == 5);
+    assert(got == 5400000000000);
+    assert(duration_parse("0 ms", 4, &got) == 1);
+    assert(got == 0);
+
+    // Reads at most len bytes.
+    assert(duration_parse("1h30m", 2, &got) == 2);
+    assert(got == 3600000000000);
+    assert(duration_parse("1.5s", 3, &got) == 0);
+    printf("OK\n");
+}
+
+typedef struct {
+    const char* str;
+    Period p;
+} PeriodTest;
+
+// Canonical forms, formatted and parsed back.
+static PeriodTest period_tests[] = {
+    {"PT0S", {0, 0, 0, 0}},
+    {"P1Y", {1, 0, 0, 0}},
+    {"P2M", {0, 2, 0, 0}},
+    {"P3D", {0, 0, 3, 0}},
+    {"PT4H", {0, 0, 0, 14400000000000}},
+    {"PT5M", {0, 0, 0, 300000000000}},
+    {"PT6S", {0, 0, 0, 6000000000}},
+    {"PT0.5S", {0, 0, 0, 500000000}},
+    {"PT0.000000001S", {0, 0, 0, 1}},
+    {"P1Y2M3DT4H5M6.5S", {1, 2, 3, 14706500000000}},
+    {"P1DT12H", {0, 0, 1, 43200000000000}},
+    {"PT36H", {0, 0, 0, 129600000000000}},
+    {"PT1H0.25S", {0, 0, 0, 3600250000000}},
+    // negative
+    {"-P1D", {0, 0, -1, 0}},
+    {"-P1Y2MT3H", {-1, -2, 0, -10800000000000}},
+    {"-PT0.5S", {0, 0, 0, -500000000}},
+    {"P1MT-1H", {0, 1, 0, -3600000000000}},
+    {"P-1M1D", {0, -1, 1, 0}},
+    {"P1DT-1H-30M-0.5S", {0, 0, 1, -5400500000000}},
+    // limits
+    {"P2147483647Y-2147483648M", {INT_MAX, INT_MIN, 0, 0}},
+    {"PT2562047H47M16.854775807S", {0, 0, 0, DURATION_MAX}},
+    {"-PT2562047H47M16.854775808S", {0, 0, 0, DURATION_MIN}},
+    {"P1YT-2562047H-47M-16.854775808S", {1, 0, 0, DURATION_MIN}},
+};
+
+static void test_period_fmt(void) {
+    printf("test_period_fmt...");
+    char buf[80];
+    for (size_t i = 0; i < sizeof(period_tests) / sizeof(period_tests[0]); i++) {
+        PeriodTest test = period_tests[i];
+        size_t n = period_fmt(test.p, buf, sizeof(buf));
+        // printf("want %s, got %s\n", test.str, buf);
+        assert(n == strlen(test.str));
+        assert(strcmp(buf, test.str) == 0);
+    }
+
+    // The longest string.
+    Period p = {INT_MIN, INT_MIN, INT_MAX, DURATION_MIN};
+    size_t n = period_fmt(p, buf, sizeof(buf));
+    assert(strcmp(buf, "P-2147483648Y-2147483648M2147483647DT-2562047H-47M-16.854775808S") == 0);
+    assert(n == strlen(buf));
+
+    // Truncates to fit the buffer, but returns the full length.
+    p = (Period){1, 2, 3, 0};
+    assert(period_fmt(p, buf, 4) == 7);
+    assert(strcmp(buf, "P1Y") == 0);
+    assert(period_fmt(p, NULL, 0) == 7);
+    printf("OK\n");
+}
+
+typedef struct {
+    const char* in;
+    Period want;
+} PeriodParseTest;
+
+// Non-canonical forms.
+static PeriodParseTest period_parse_tests[] = {
+    {"P0D", {0, 0, 0, 0}},
+    {"PT0S", {0, 0, 0, 0}},
+    {"P0Y0M0DT0H0M0S", {0, 0, 0, 0}},
+    {"+P1D", {0, 0, 1, 0}},
+    {"P+1D", {0, 0, 1, 0}},
+    {"-P-1D", {0, 0, 1, 0}},
+    {"P2W", {0, 0, 14, 0}},
+    {"P1W3D", {0, 0, 10, 0}},
+    {"P-1W3D", {0, 0, -4, 0}},
+    {"P14M", {0, 14, 0, 0}},
+    {"PT90M", {0, 0, 0, 5400000000000}},
+    {"PT0,5S", {0, 0, 0, 500000000}},
+    {"PT1.5H", {0, 0, 0, 5400000000000}},
+    {"PT1.5M", {0, 0, 0, 90000000000}},
+    {"PT2H0.5M", {0, 0, 0, 7230000000000}},
+    {"PT0.1234567899S", {0, 0, 0, 123456789}},
+    {"PT-0.0000000001S", {0, 0, 0, 0}},
+    {"PT0.3333333333333333333H", {0, 0, 0, 1199999999999}},
+    {"P000001D", {0, 0, 1, 0}},
+    {"PT1H-60M", {0, 0, 0, 0}},
+};
+
+static const char* period_parse_errors[] = {
+    // invalid
+    "",
+    "P",
+    "PT",
+    "-P",
+    "P1DT",
+    "1D",
+    "p1d",
+    "P1d",
+    "P1",
+    "PT1",
+    "P1H",
+    "PT1D",
+    "PT1Y",
+    "P1D1Y",
+    "P1M1Y",
+    "P1D1D",
+    "PT1S1M",
+    "PT1M1M",
+    "P1.5D",
+    "P1,5Y",
+    "PT.5S",
+    "PT1.S",
+    "PT1.5H30M",
+    "P--1D",
+    "P-D",
+    "P D",
+    // overflow
+    "P2147483648Y",
+    "P-2147483649M",
+    "P306783379W",
+    "P2147483647W",
+    "P2147483647D1W",
+    "PT2562048H",
+    "PT2562047H47M16.854775808S",
+    "PT9223372036.854775808S",
+    "PT99999999999999999999S",
+    "PT2562047H47M16.854775807S1S",
+    "PT-2562047H-47M-16.854775808S-0.000000001S",
+};
+
+static void test_period_parse(void) {
+    printf("test_period_parse...");
+    for (size_t i = 0; i < sizeof(period_tests) / sizeof(period_tests[0]); i++) {
+        PeriodTest test = period_tests[i];
+        Period got = {-1, -1, -1, -1};
+        size_t n = period_parse(test.str, strlen(test.str), &got);
+        // printf("%s: got %d %d %d %lld\n", test.str, got.years, got.months, got.days,
+        //        got.duration);
+        assert(n == strlen(test.str));
+        assert(got.years == test.p.years && got.months == test.p.months);
+        assert(got.days == test.p.days && got.duration == test.p.duration);
+    }
+    for (size_t i = 0; i < sizeof(period_parse_tests) / sizeof(period_parse_tests[0]); i++) {
+        PeriodParseTest test = period_parse_tests[i];
+        Period got = {-1, -1, -1, -1};
+        size_t n = period_parse(test.in, strlen(test.in), &got);
+        assert(n == strlen(test.in));
+        assert(got.years == test.want.years && got.months == test.want.months);
+        assert(got.days == test.want.days && got.duration == test.want.duration);
+    }
+    for (size_t i = 0; i < sizeof(period_parse_errors) / sizeof(period_parse_errors[0]); i++) {
+        const char* in = period_parse_errors[i];
+        Period got = {42, 42, 42, 42};
+        size_t n = period_parse(in, strlen(in), &got);
+        // printf("%s: %zu\n", in, n);
+        assert(n == 0);
+        assert(got.years == 42 && got.months == 42 && got.days == 42 && got.duration == 42);
+    }
+
+    // Parses a prefix of the buffer.
+    Period got;
+    const char* s = "P1DT2H/2011-01-01";
+    assert(period_parse(s, strlen(s), &got) == 6);
+    assert(got.days == 1 && got.duration == 7200000000000);
+
+    // Reads at most len bytes.
+    assert(period_parse("P1DT2H", 3, &got) == 3);
+    assert(got.days == 1 && got.duration == 0);
+    assert(period_parse("PT2.5S", 5, &got) == 0);
+    printf("OK\n");
+}
+
 int main(void) {
     test_to_x();
     test_to_minutes();
@@ -247,4 +598,8 @@ int main(void) {
     test_truncate();
     test_round();
     test_abs();
+    test_fmt();
+    test_parse();
+    test_period_fmt();
+    test_period_parse();
 }
@@ -4,6 +4,7 @@
 // Usage examples for the vaqt package.
 
 #include <stdio.h>
+#include <string.h>
 #include "vaqt.h"
 
 static void example_time_now(void) {
@@ -16,6 +17,43 @@ static void example_time_now(void) {
     // 2025-10-13T19:46:07.726485000Z
 }
 
+static void example_time_now_coarse(void) {
+    printf("---\ntime_now_coarse:\n");
+
+    Time t = time_now_coarse();
+    char buf[64];
+    time_fmt_iso(t, 0, buf, sizeof(buf));
+    printf("%s\n", buf);
+    // 2025-10-13T19:46:07.724103559Z
+}
+
+static void example_time_now_cached(void) {
+    printf("---\ntime_now_cached:\n");
+
+    if (!time_clock_start(TIME_MILLI)) {
+        // not supported on this platform
+    }
+    Time t = time_now_cached();
+    char buf[64];
+    time_fmt_iso(t, 0, buf, sizeof(buf));
+    printf("%s\n", buf);
+    // 2025-10-13T19:46:07.725913000Z
+    time_clock_stop();
+}
+
+static void example_time_now_tsc(void) {
+    printf("---\ntime_now_tsc:\n");
+
+    if (!time_tsc_init()) {
+        // no invariant TSC, time_now_tsc falls back to time_now
+    }
+    Time t = time_now_tsc();
+    char buf[64];
+    time_fmt_iso(t, 0, buf, sizeof(buf));
+    printf("%s\n", buf);
+    // 2025-10-13T19:46:07.726512938Z
+}
+
 static void example_time_date(void) {
     printf("---\ntime_date:\n");
 
@@ -50,6 +88,26 @@ static void example_time_date(void) {
     // 2011-11-18T20:56:35.666777888Z
 }
 
+static void example_time_date_batch(void) {
+    printf("---\ntime_date_batch:\n");
+
+    int year[] = {2011, 2024, 2024};
+    int month[] = {TIME_NOVEMBER, TIME_FEBRUARY, TIME_MARCH};
+    int day[] = {18, 29, 32};
+    int hour[] = {15, 0, 12};
+    int min[] = {56, 0, 30};
+    Time t[3];
+    time_date_batch(year, month, day, hour, min, NULL, NULL, NULL, 0, 3, t);
+    for (size_t i = 0; i < 3; i++) {
+        char buf[64];
+        time_fmt_iso(t[i], 0, buf, sizeof(buf));
+        printf("%s\n", buf);
+    }
+    // 2011-11-18T15:56:00Z
+    // 2024-02-29T00:00:00Z
+    // 2024-04-01T12:30:00Z
+}
+
 static void example_time_get_year(void) {
     printf("---\ntime_get_year:\n");
 
@@ -162,6 +220,60 @@ static void example_time_get_clock(void) {
     // 21, 22, 15
 }
 
+static void example_time_get_fields(void) {
+    printf("---\ntime_get_fields:\n");
+
+    Time t = time_date(2024, TIME_AUGUST, 6, 21, 22, 15, 431295000, 0);
+    TimeFields f;
+    time_get_fields(t, &f);
+    printf("year = %d, month = %d, day = %d, yday = %d, weekday = %d\n", f.year, f.month, f.day,
+           f.yday, f.weekday);
+    printf("hour = %d, min = %d, sec = %d, nsec = %d\n", f.hour, f.min, f.sec, f.nsec);
+    printf("iso_year = %d, iso_week = %d\n", f.iso_year, f.iso_week);
+    // year = 2024, month = 8, day = 6, yday = 219, weekday = 2
+    // hour = 21, min = 22, sec = 15, nsec = 431295000
+    // iso_year = 2024, iso_week = 32
+}
+
+static void example_time_get_date_batch(void) {
+    printf("---\ntime_get_date_batch:\n");
+
+    Time in[2] = {
+        time_date(2024, TIME_AUGUST, 6, 21, 22, 15, 0, 0),
+        time_date(2025, TIME_JANUARY, 1, 0, 0, 0, 0, 0),
+    };
+    int year[2], month[2], day[2];
+    time_get_date_batch(in, 2, year, month, day);
+    printf("%d-%d-%d, %d-%d-%d\n", year[0], month[0], day[0], year[1], month[1], day[1]);
+    // 2024-8-6, 2025-1-1
+}
+
+static void example_time_get_clock_batch(void) {
+    printf("---\ntime_get_clock_batch:\n");
+
+    Time in[2] = {
+        time_date(2024, TIME_AUGUST, 6, 21, 22, 15, 0, 0),
+        time_date(2025, TIME_JANUARY, 1, 0, 0, 0, 0, 0),
+    };
+    int hour[2], min[2], sec[2];
+    time_get_clock_batch(in, 2, hour, min, sec);
+    printf("%d:%d:%d, %d:%d:%d\n", hour[0], min[0], sec[0], hour[1], min[1], sec[1]);
+    // 21:22:15, 0:0:0
+}
+
+static void example_time_get_weekday_batch(void) {
+    printf("---\ntime_get_weekday_batch:\n");
+
+    Time in[2] = {
+        time_date(2024, TIME_AUGUST, 6, 21, 22, 15, 0, 0),
+        time_date(2025, TIME_JANUARY, 1, 0, 0, 0, 0, 0),
+    };
+    int weekday[2];
+    time_get_weekday_batch(in, 2, weekday);
+    printf("%d, %d\n", weekday[0], weekday[1]);
+    // 2, 3
+}
+
 static void example_time_unix(void) {
     printf("---\ntime_unix:\n");
 
@@ -367,6 +479,18 @@ static void example_time_add_date(void) {
     // "2024-08-07T21:22:15Z"
 }
 
+static void example_time_add_period(void) {
+    printf("---\ntime_add_period:\n");
+
+    Time t = time_date(2011, TIME_JANUARY, 31, 10, 0, 0, 0, 0);
+    Period p = {0, 1, 0, TIME_HOUR};  // P1MT1H
+    Time result = time_add_period(t, p);
+    char buf[64];
+    time_fmt_iso(result, 0, buf, sizeof(buf));
+    printf("%s\n", buf);
+    // 2011-03-03T11:00:00Z
+}
+
 static void example_time_truncate(void) {
     printf("---\ntime_truncate:\n");
 
@@ -401,6 +525,61 @@ static void example_time_fmt_iso(void) {
     // "2011-11-18T15:56:35.666777888Z"
 }
 
+static void example_time_fmt_iso_prec(void) {
+    printf("---\ntime_fmt_iso_prec:\n");
+
+    Time t = time_date(2011, TIME_NOVEMBER, 18, 15, 56, 35, 666700000, 0);
+    char buf[64];
+
+    time_fmt_iso_prec(t, 0, 3, buf, sizeof(buf));
+    printf("%s\n", buf);
+    // buf = "2011-11-18T15:56:35.666Z"
+
+    time_fmt_iso_prec(t, 0, TIME_PREC_TRIM, buf, sizeof(buf));
+    printf("%s\n", buf);
+    // buf = "2011-11-18T15:56:35.6667Z"
+}
+
+static void example_time_fmt_iso_batch(void) {
+    printf("---\ntime_fmt_iso_batch:\n");
+
+    Time in[3];
+    in[0] = time_date(2011, TIME_NOVEMBER, 18, 15, 56, 35, 666700000, 0);
+    in[1] = time_date(2011, TIME_NOVEMBER, 18, 15, 56, 36, 0, 0);
+    in[2] = time_date(2011, TIME_NOVEMBER, 18, 15, 56, 37, 500000000, 0);
+
+    size_t size = time_fmt_iso_batch_size(in, 3, 0, TIME_PREC_TRIM);
+    char buf[128];
+    int32_t offsets[4];
+    size_t n = time_fmt_iso_batch(in, 3, 0, TIME_PREC_TRIM, buf, size, offsets);
+    printf("%zu {%d, %d, %d, %d} %.*s\n", n, (int)offsets[0], (int)offsets[1], (int)offsets[2],
+           (int)offsets[3], (int)n, buf);
+    // n = 67, offsets = {0, 25, 45, 67}
+    // buf = "2011-11-18T15:56:35.6667Z2011-11-18T15:56:36Z2011-11-18T15:56:37.5Z"
+
+    n = time_fmt_iso_batch(in, 3, 0, 3, buf, sizeof(buf), NULL);
+    printf("%zu %.*s\n", n, (int)n, buf);
+    // n = 72, each string is 24 bytes wide
+    // buf = "2011-11-18T15:56:35.666Z2011-11-18T15:56:36.000Z2011-11-18T15:56:37.500Z"
+}
+
+static void example_time_fmt_iso_cached(void) {
+    printf("---\ntime_fmt_iso_cached:\n");
+
+    TimeFmtCache cache = {0};
+    Time t = time_date(2011, TIME_NOVEMBER, 18, 15, 56, 35, 666777888, 0);
+    char buf[64];
+
+    time_fmt_iso_cached(&cache, t, 0, 6, buf, sizeof(buf));
+    printf("%s\n", buf);
+    // buf = "2011-11-18T15:56:35.666777Z"
+
+    t = time_add(t, 100 * TIME_MILLI);
+    time_fmt_iso_cached(&cache, t, 0, 6, buf, sizeof(buf));
+    printf("%s\n", buf);
+    // buf = "2011-11-18T15:56:35.766777Z" (the same second, uses the cache)
+}
+
 static void example_time_fmt_datetime(void) {
     printf("---\ntime_fmt_datetime:\n");
 
@@ -431,6 +610,20 @@ static void example_time_fmt_time(void) {
     // "15:56:35"
 }
 
+static void example_time_fmt_layout(void) {
+    printf("---\ntime_fmt_layout:\n");
+
+    TimeLayout layout;
+    if (!time_layout_compile("Mon, 02 Jan 2006 15:04:05.000 -0700", &layout)) {
+        // layout is too long
+    }
+    Time t = time_date(2011, TIME_NOVEMBER, 18, 15, 56, 35, 666777888, 0);
+    char buf[64];
+    size_t n = time_fmt_layout(t, 5 * 3600, &layout, buf, sizeof(buf));
+    printf("%s\n", buf);
+    // buf = "Fri, 18 Nov 2011 20:56:35.666 +0500"
+}
+
 static void example_time_parse(void) {
     printf("---\ntime_parse:\n");
 
@@ -441,6 +634,87 @@ static void example_time_parse(void) {
     // "2011-11-18T15:56:35.666777888Z"
 }
 
+static void example_time_parse_n(void) {
+    printf("---\ntime_parse_n:\n");
+
+    const char* line = "2011-11-18T15:56:35Z GET /index.html";
+    Time t;
+    size_t n = time_parse_n(line, strlen(line), &t);
+    char buf[64];
+    time_fmt_iso(t, 0, buf, sizeof(buf));
+    printf("n = %zu, t = %s\n", n, buf);
+    // n = 20, t = 2011-11-18T15:56:35Z
+}
+
+static void example_time_parse_layout(void) {
+    printf("---\ntime_parse_layout:\n");
+
+    TimeLayout layout;
+    time_layout_compile("02/Jan/2006:15:04:05 -0700", &layout);
+
+    const char* line = "18/Nov/2011:15:56:35 +0500 \"GET /index.html\"";
+    Time t;
+    size_t err_pos;
+    size_t n = time_parse_layout(line, strlen(line), &layout, &t, &err_pos);
+    char buf[64];
+    time_fmt_iso(t, 0, buf, sizeof(buf));
+    printf("%zu %s\n", n, buf);
+    // n = 26, t = 2011-11-18T10:56:35Z
+
+    n = time_parse_layout("18/Nov/2011 15:56:35", 20, &layout, &t, &err_pos);
+    printf("%zu %zu\n", n, err_pos);
+    // n = 0, err_pos = 11
+}
+
+static void example_time_parse_batch(void) {
+    printf("---\ntime_parse_batch:\n");
+
+    const char* strs[] = {"2011-11-18T15:56:35Z", "2011-11-18 15:56:35", "2011-11-18T15:56"};
+    size_t lens[] = {20, 19, 16};
+    Time out[3];
+    uint8_t valid[1];
+    size_t count = time_parse_batch(strs, lens, 3, out, valid);
+    printf("%zu %02x\n", count, valid[0]);
+    // count = 2, valid = 0x03
+
+    const char* data = "2011-11-18T15:56:35Z2011-11-18";
+    int32_t offsets[] = {0, 20, 30};
+    count = time_parse_batch_offsets(data, offsets, 2, out, valid);
+    printf("%zu %02x\n", count, valid[0]);
+    // count = 2, valid = 0x03
+}
+
+static void example_time_fmt_http(void) {
+    printf("---\ntime_fmt_http:\n");
+
+    Time t = time_date(1994, TIME_NOVEMBER, 6, 8, 49, 37, 0, 0);
+    char buf[64];
+    time_fmt_http(t, buf, sizeof(buf));
+    printf("%s\n", buf);
+    // buf = "Sun, 06 Nov 1994 08:49:37 GMT"
+}
+
+static void example_time_fmt_http_cached(void) {
+    printf("---\ntime_fmt_http_cached:\n");
+
+    char buf[64];
+    time_fmt_http_cached(time_now(), buf, sizeof(buf));
+    printf("%s\n", buf);
+    // buf = "Fri, 18 Nov 2011 15:56:35 GMT"
+}
+
+static void example_time_parse_http(void) {
+    printf("---\ntime_parse_http:\n");
+
+    const char* s = "Sunday, 06-Nov-94 08:49:37 GMT";
+    Time t;
+    size_t n = time_parse_http(s, strlen(s), &t);
+    char buf[64];
+    time_fmt_iso(t, 0, buf, sizeof(buf));
+    printf("%zu %s\n", n, buf);
+    // n = 30, t = 1994-11-06T08:49:37Z
+}
+
 static void example_time_marshal_binary(void) {
     printf("---\ntime_marshal_binary:\n");
 
@@ -463,6 +737,167 @@ static void example_time_unmarshal_binary(void) {
     // true
 }
 
+static void example_time_marshal_binary_batch(void) {
+    printf("---\ntime_marshal_binary_batch:\n");
+
+    Time in[3] = {time_unix(-1, 0), time_unix(0, 0), time_unix(1, 0)};
+    uint8_t buf[3 * TIME_BINARY_SIZE];
+    time_marshal_binary_batch(in, 3, buf);
+
+    Time out[3];
+    time_unmarshal_binary_batch(buf, 3, out);
+    bool equal = time_equal(out[0], in[0]) && time_equal(out[2], in[2]);
+    printf("%s\n", equal ? "true" : "false");
+    // true
+}
+
+static void example_time_marshal_key(void) {
+    printf("---\ntime_marshal_key:\n");
+
+    Time t1 = time_date(1, TIME_JANUARY, 1, 0, 0, 0, 0, 0);
+    Time t2 = time_add(t1, -TIME_SECOND);
+    uint8_t k1[TIME_KEY_SIZE], k2[TIME_KEY_SIZE];
+    time_marshal_key(t1, k1);
+    time_marshal_key(t2, k2);
+    int cmp = memcmp(k2, k1, TIME_KEY_SIZE);
+    printf("%s\n", cmp < 0 ? "true" : "false");
+    // true
+}
+
+static void example_time_unmarshal_key(void) {
+    printf("---\ntime_unmarshal_key:\n");
+
+    Time t1 = time_date(2011, TIME_NOVEMBER, 18, 15, 56, 35, 666777888, 0);
+    uint8_t key[TIME_KEY_SIZE];
+    time_marshal_key(t1, key);
+    Time t2 = time_unmarshal_key(key);
+    bool equal = time_equal(t1, t2);
+    printf("%s\n", equal ? "true" : "false");
+    // true
+}
+
+static void example_time_marshal_key_batch(void) {
+    printf("---\ntime_marshal_key_batch:\n");
+
+    Time in[3] = {time_unix(-1, 0), time_unix(0, 0), time_unix(1, 0)};
+    uint8_t buf[3 * TIME_KEY_SIZE];
+    time_marshal_key_batch(in, 3, buf);
+
+    Time out[3];
+    time_unmarshal_key_batch(buf, 3, out);
+    bool equal = time_equal(out[0], in[0]) && time_equal(out[2], in[2]);
+    printf("%s\n", equal ? "true" : "false");
+    // true
+}
+
+static void example_time_dod_encode(void) {
+    printf("---\ntime_dod_encode:\n");
+
+    Time in[100];
+    Time t = time_date(2025, TIME_JANUARY, 1, 0, 0, 0, 0, 0);
+    for (int i = 0; i < 100; i++) {
+        in[i] = time_add(t, i * 10 * TIME_SECOND);
+    }
+
+    uint8_t buf[100 * TIME_DOD_MAX_SIZE];
+    TimeDodState st = {0};
+    size_t size = time_dod_encode(&st, in, 100, buf, sizeof(buf));
+    printf("%zu\n", size);
+    // 110
+}
+
+static void example_time_dod_decode(void) {
+    printf("---\ntime_dod_decode:\n");
+
+    Time in[100];
+    Time t = time_date(2025, TIME_JANUARY, 1, 0, 0, 0, 0, 0);
+    for (int i = 0; i < 100; i++) {
+        in[i] = time_add(t, i * 10 * TIME_SECOND);
+    }
+    uint8_t buf[100 * TIME_DOD_MAX_SIZE];
+    TimeDodState enc = {0};
+    size_t size = time_dod_encode(&enc, in, 100, buf, sizeof(buf));
+
+    Time out[100];
+    TimeDodState dec = {0};
+    size_t n = time_dod_decode(&dec, buf, size, out, 100);
+    bool equal = time_equal(out[0], in[0]) && time_equal(out[99], in[99]);
+    printf("%zu %s\n", n, equal ? "true" : "false");
+    // 110 true
+}
+
+static void example_time_for_encode(void) {
+    printf("---\ntime_for_encode:\n");
+
+    Time in[100];
+    Time t = time_date(2025, TIME_JANUARY, 1, 0, 0, 0, 0, 0);
+    for (int i = 0; i < 100; i++) {
+        in[i] = time_add(t, i * TIME_MILLI);
+    }
+
+    uint8_t buf[TIME_FOR_HEADER_SIZE + 8 * (100 + 1)];
+    size_t size = time_for_encode(in, 100, buf, sizeof(buf));
+    printf("%zu\n", size);
+    // 363
+}
+
+static void example_time_for_open(void) {
+    printf("---\ntime_for_open:\n");
+
+    Time in[100];
+    Time t = time_date(2025, TIME_JANUARY, 1, 0, 0, 0, 0, 0);
+    for (int i = 0; i < 100; i++) {
+        in[i] = time_add(t, i * TIME_MILLI);
+    }
+    uint8_t buf[TIME_FOR_HEADER_SIZE + 8 * (100 + 1)];
+    size_t size = time_for_encode(in, 100, buf, sizeof(buf));
+
+    TimeForBlock block;
+    bool ok = time_for_open(buf, size, &block);
+    printf("%s %u %u\n", ok ? "true" : "false", block.n, block.width);
+    // true 100 27
+}
+
+static void example_time_for_get(void) {
+    printf("---\ntime_for_get:\n");
+
+    Time in[100];
+    Time t = time_date(2025, TIME_JANUARY, 1, 0, 0, 0, 0, 0);
+    for (int i = 0; i < 100; i++) {
+        in[i] = time_add(t, i * TIME_MILLI);
+    }
+    uint8_t buf[TIME_FOR_HEADER_SIZE + 8 * (100 + 1)];
+    size_t size = time_for_encode(in, 100, buf, sizeof(buf));
+    TimeForBlock block;
+    time_for_open(buf, size, &block);
+
+    Time got = time_for_get(&block, 42);
+    char str[64];
+    time_fmt_iso_prec(got, 0, 3, str, sizeof(str));
+    printf("%s\n", str);
+    // 2025-01-01T00:00:00.042Z
+}
+
+static void example_time_for_decode(void) {
+    printf("---\ntime_for_decode:\n");
+
+    Time in[100];
+    Time t = time_date(2025, TIME_JANUARY, 1, 0, 0, 0, 0, 0);
+    for (int i = 0; i < 100; i++) {
+        in[i] = time_add(t, i * TIME_MILLI);
+    }
+    uint8_t buf[TIME_FOR_HEADER_SIZE + 8 * (100 + 1)];
+    size_t size = time_for_encode(in, 100, buf, sizeof(buf));
+    TimeForBlock block;
+    time_for_open(buf, size, &block);
+
+    Time out[100];
+    time_for_decode(&block, out);
+    bool equal = time_equal(out[0], in[0]) && time_equal(out[99], in[99]);
+    printf("%s\n", equal ? "true" : "false");
+    // true
+}
+
 static void example_duration_to_micro(void) {
     printf("---\nduration_to_micro:\n");
 
@@ -537,9 +972,90 @@ static void example_duration_abs(void) {
     // 5000000000
 }
 
+static void example_duration_fmt(void) {
+    printf("---\nduration_fmt:\n");
+
+    char buf[32];
+    duration_fmt(1 * TIME_HOUR + 2 * TIME_MINUTE + 3500 * TIME_MILLI, buf, sizeof(buf));
+    printf("%s\n", buf);
+    // 1h2m3.5s
+
+    duration_fmt(1500 * TIME_MICRO, buf, sizeof(buf));
+    printf("%s\n", buf);
+    // 1.5ms
+}
+
+static void example_duration_parse(void) {
+    printf("---\nduration_parse:\n");
+
+    Duration d;
+    const char* s = "1h30m";
+    size_t n = duration_parse(s, strlen(s), &d);
+    printf("%zu %lld\n", n, d);
+    // 5 5400000000000
+
+    s = "1.5us";
+    n = duration_parse(s, strlen(s), &d);
+    printf("%zu %lld\n", n, d);
+    // 5 1500
+}
+
+static void example_period_fmt(void) {
+    printf("---\nperiod_fmt:\n");
+
+    char buf[80];
+    Period p = {1, 2, 3, 4 * TIME_HOUR + 5 * TIME_MINUTE + 6500 * TIME_MILLI};
+    period_fmt(p, buf, sizeof(buf));
+    printf("%s\n", buf);
+    // P1Y2M3DT4H5M6.5S
+}
+
+static void example_period_parse(void) {
+    printf("---\nperiod_parse:\n");
+
+    Period p;
+    const char* s = "P1MT1.5H";
+    size_t n = period_parse(s, strlen(s), &p);
+    printf("%zu %d %d %d %lld\n", n, p.years, p.months, p.days, p.duration);
+    // 8 0 1 0 5400000000000
+}
+
+static void example_time_mono_now(void) {
+    printf("---\ntime_mono_now:\n");
+
+    MonoTime start = time_mono_now();
+    // do some work
+    Duration elapsed = time_mono_since(start);
+    printf("%.3f seconds\n", duration_to_seconds(elapsed));
+    // elapsed is the duration since start
+}
+
+static void example_time_mono_add(void) {
+    printf("---\ntime_mono_add:\n");
+
+    MonoTime deadline = time_mono_add(time_mono_now(), 5 * TIME_SECOND);
+    Duration remaining = time_mono_until(deadline);
+    printf("%.3f seconds\n", duration_to_seconds(remaining));
+    // remaining is about 5 seconds
+}
+
+static void example_time_mono_sub(void) {
+    printf("---\ntime_mono_sub:\n");
+
+    MonoTime start = time_mono_now();
+    MonoTime end = time_mono_add(start, 1500 * TIME_MILLI);
+    Duration d = time_mono_sub(end, start);
+    printf("%.3f seconds\n", duration_to_seconds(d));
+    // 1.500 seconds
+}
+
 int main(void) {
     example_time_now();
+    example_time_now_coarse();
+    example_time_now_cached();
+    example_time_now_tsc();
     example_time_date();
+    example_time_date_batch();
     example_time_get_year();
     example_time_get_month();
     example_time_get_day();
@@ -552,6 +1068,10 @@ int main(void) {
     example_time_get_isoweek();
     example_time_get_date();
     example_time_get_clock();
+    example_time_get_fields();
+    example_time_get_date_batch();
+    example_time_get_clock_batch();
+    example_time_get_weekday_batch();
     example_time_unix();
     example_time_milli();
     example_time_micro();
@@ -572,15 +1092,36 @@ int main(void) {
     example_time_since();
     example_time_until();
     example_time_add_date();
+    example_time_add_period();
     example_time_truncate();
     example_time_round();
     example_time_fmt_iso();
+    example_time_fmt_iso_prec();
+    example_time_fmt_iso_batch();
+    example_time_fmt_iso_cached();
     example_time_fmt_datetime();
     example_time_fmt_date();
     example_time_fmt_time();
+    example_time_fmt_layout();
     example_time_parse();
+    example_time_parse_n();
+    example_time_parse_layout();
+    example_time_parse_batch();
+    example_time_fmt_http();
+    example_time_fmt_http_cached();
+    example_time_parse_http();
     example_time_marshal_binary();
     example_time_unmarshal_binary();
+    example_time_marshal_binary_batch();
+    example_time_marshal_key();
+    example_time_unmarshal_key();
+    example_time_marshal_key_batch();
+    example_time_dod_encode();
+    example_time_dod_decode();
+    example_time_for_encode();
+    example_time_for_open();
+    example_time_for_get();
+    example_time_for_decode();
     example_duration_to_micro();
     example_duration_to_milli();
     example_duration_to_seconds();
@@ -589,4 +1130,11 @@ int main(void) {
     example_duration_truncate();
     example_duration_round();
     example_duration_abs();
+    example_duration_fmt();
+    example_duration_parse();
+    example_period_fmt();
+    example_period_parse();
+    example_time_mono_now();
+    example_time_mono_add();
+    example_time_mono_sub();
 }
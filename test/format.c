@@ -7,7 +7,10 @@
 // Time formatting tests.
 
 #include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "vaqt.h"
@@ -25,8 +28,17 @@ FormatTest fmt_iso_tests[] = {
     {2011, 11, 18, 15, 56, 35, 0, "2011-11-18T21:26:35+05:30", 5 * 3600 + 30 * 60},
     {2011, 11, 18, 15, 56, 35, 0, "2011-11-18T10:56:35-05:00", -5 * 3600},
     {2011, 11, 18, 15, 56, 35, 0, "2011-11-18T10:26:35-05:30", -5 * 3600 - 30 * 60},
+    {2011, 11, 18, 15, 56, 35, 0, "2011-11-18T15:26:35-00:30", -30 * 60},
+    {2011, 11, 18, 15, 56, 35, 0, "2011-11-18T16:26:35+00:30", 30 * 60},
+    {2011, 11, 18, 15, 56, 35, 0, "2011-11-18T15:56:05-00:00", -30},
     {2011, 11, 18, 15, 56, 35, 666777888, "2011-11-18T20:56:35.666777888+05:00", 5 * 3600},
     {2011, 11, 18, 15, 56, 35, 666777888, "2011-11-18T10:56:35.666777888-05:00", -5 * 3600},
+    {2011, 11, 18, 15, 56, 35, 1, "2011-11-18T15:56:35.000000001Z", 0},
+    {1, 1, 1, 0, 0, 0, 0, "0001-01-01T00:00:00Z", 0},
+    {0, 12, 31, 23, 59, 59, 0, "0000-12-31T23:59:59Z", 0},
+    {-5, 1, 1, 0, 0, 0, 0, "-005-01-01T00:00:00Z", 0},
+    {-12345, 1, 1, 0, 0, 0, 0, "-12345-01-01T00:00:00Z", 0},
+    {12345, 1, 1, 0, 0, 0, 0, "12345-01-01T00:00:00Z", 0},
 };
 
 static void test_fmt_iso(void) {
@@ -43,6 +55,165 @@ static void test_fmt_iso(void) {
     printf("OK\n");
 }
 
+typedef struct {
+    int prec;
+    int nsec;
+    int offset_sec;
+    const char* want;
+} FormatPrecTest;
+
+static FormatPrecTest fmt_iso_prec_tests[] = {
+    {0, 666777888, 0, "2011-11-18T15:56:35Z"},
+    {1, 666777888, 0, "2011-11-18T15:56:35.6Z"},
+    {3, 666777888, 0, "2011-11-18T15:56:35.666Z"},
+    {6, 666777888, 0, "2011-11-18T15:56:35.666777Z"},
+    {9, 666777888, 0, "2011-11-18T15:56:35.666777888Z"},
+    {12, 666777888, 0, "2011-11-18T15:56:35.666777888Z"},
+    {3, 0, 0, "2011-11-18T15:56:35.000Z"},
+    {3, 666777888, 5 * 3600, "2011-11-18T20:56:35.666+05:00"},
+    {TIME_PREC_TRIM, 666777888, 0, "2011-11-18T15:56:35.666777888Z"},
+    {TIME_PREC_TRIM, 666777000, 0, "2011-11-18T15:56:35.666777Z"},
+    {TIME_PREC_TRIM, 600000000, 0, "2011-11-18T15:56:35.6Z"},
+    {TIME_PREC_TRIM, 1, 0, "2011-11-18T15:56:35.000000001Z"},
+    {TIME_PREC_TRIM, 0, 0, "2011-11-18T15:56:35Z"},
+    {TIME_PREC_TRIM, 120000000, -5 * 3600, "2011-11-18T10:56:35.12-05:00"},
+};
+
+static void test_fmt_iso_prec(void) {
+    printf("test_fmt_iso_prec...");
+    for (size_t i = 0; i < sizeof(fmt_iso_prec_tests) / sizeof(fmt_iso_prec_tests[0]); i++) {
+        FormatPrecTest test = fmt_iso_prec_tests[i];
+        Time t = time_date(2011, 11, 18, 15, 56, 35, test.nsec, 0);
+        char got[64];
+        size_t n = time_fmt_iso_prec(t, test.offset_sec, test.prec, got, sizeof(got));
+        // printf("want: %s, got: %s\n", test.want, got);
+        assert(strcmp(got, test.want) == 0);
+        assert(n == strlen(test.want));
+        if (test.prec < 0 || test.prec >= 9) {
+            assert(time_equal(time_parse(got), t));  // lossless
+        }
+    }
+    printf("OK\n");
+}
+
+// fmt_iso_roundtrip_offsets are whole-minute offsets, including negative
+// ones under an hour, that time_fmt_iso_prec must keep the sign of.
+static const int fmt_iso_roundtrip_offsets[] = {
+    0, -30 * 60, 30 * 60, -59 * 60, -60, -5 * 3600 - 30 * 60, 14 * 3600, -12 * 3600,
+};
+
+static void test_fmt_iso_roundtrip(void) {
+    printf("test_fmt_iso_roundtrip...");
+    Time t = time_date(2011, 11, 18, 15, 56, 35, 666777888, 0);
+    size_t noffsets = sizeof(fmt_iso_roundtrip_offsets) / sizeof(fmt_iso_roundtrip_offsets[0]);
+    for (size_t i = 0; i < noffsets; i++) {
+        int offset_sec = fmt_iso_roundtrip_offsets[i];
+        char buf[64];
+        size_t n = time_fmt_iso_prec(t, offset_sec, TIME_PREC_TRIM, buf, sizeof(buf));
+        Time got;
+        // printf("%d: %s\n", offset_sec, buf);
+        assert(time_parse_n(buf, n, &got) == n);
+        assert(time_equal(got, t));
+    }
+    printf("OK\n");
+}
+
+static void test_fmt_iso_cached(void) {
+    printf("test_fmt_iso_cached...");
+    TimeFmtCache cache = {0};
+    Time t = time_date(2011, TIME_NOVEMBER, 18, 15, 56, 35, 0, 0);
+    int precs[] = {TIME_PREC_TRIM, 0, 3, 9};
+    int tz_offsets[] = {0, 0, 5 * 3600 + 30 * 60, -5 * 3600};
+    for (int i = 0; i < 10000; i++) {
+        // Mostly within the same second, sometimes with a different offset,
+        // and sometimes going back in time.
+        t = time_add(t, (Duration)(i % 7 == 6 ? -3 : 1) * 123456789);
+        int offset_sec = tz_offsets[i / 50 % 4];
+        int prec = precs[i % 4];
+        char want[64], got[64];
+        size_t want_n = time_fmt_iso_prec(t, offset_sec, prec, want, sizeof(want));
+        size_t n = time_fmt_iso_cached(&cache, t, offset_sec, prec, got, sizeof(got));
+        assert(n == want_n);
+        assert(strcmp(got, want) == 0);
+    }
+
+    // Years of different widths.
+    Time years[] = {
+        time_date(-12345, TIME_JANUARY, 1, 0, 0, 0, 0, 0),
+        time_date(-5, TIME_JANUARY, 1, 0, 0, 0, 0, 0),
+        time_date(12345, TIME_JANUARY, 1, 0, 0, 0, 0, 0),
+    };
+    for (size_t i = 0; i < sizeof(years) / sizeof(years[0]); i++) {
+        char want[64], got[64];
+        time_fmt_iso_prec(years[i], 3600, 9, want, sizeof(want));
+        time_fmt_iso_cached(&cache, years[i], 3600, 9, got, sizeof(got));
+        assert(strcmp(got, want) == 0);
+    }
+
+    // Truncates like snprintf.
+    char got[10];
+    size_t n = time_fmt_iso_cached(&cache, t, 0, 3, got, sizeof(got));
+    assert(n == 24);
+    assert(strcmp(got, "2011-11-1") == 0);
+    printf("OK\n");
+}
+
+static void test_fmt_iso_batch(void) {
+    printf("test_fmt_iso_batch...");
+    // Spans several chunks, with years of different widths at the end.
+    enum { N = 600 };
+    static Time in[N];
+    Time t = time_date(1999, TIME_DECEMBER, 31, 23, 59, 59, 123456789, 0);
+    for (size_t i = 0; i < N; i++) {
+        in[i] = time_add(t, (Duration)i * 7919 * TIME_SECOND + (Duration)i * 1000);
+    }
+    in[0].nsec = 0;
+    in[1].nsec = 100000000;
+    in[N - 3] = time_date(-5, TIME_JANUARY, 1, 0, 0, 0, 0, 0);
+    in[N - 2] = time_date(12345, TIME_JANUARY, 1, 0, 0, 0, 0, 0);
+    in[N - 1] = time_date(-12345, TIME_JANUARY, 1, 0, 0, 0, 0, 0);
+
+    int precs[] = {TIME_PREC_TRIM, 0, 3, 9};
+    int tz_offsets[] = {0, 5 * 3600 + 30 * 60, -5 * 3600};
+    static char buf[N * 64];
+    static int32_t offsets[N + 1];
+    for (size_t p = 0; p < sizeof(precs) / sizeof(precs[0]); p++) {
+        for (size_t o = 0; o < sizeof(tz_offsets) / sizeof(tz_offsets[0]); o++) {
+            int prec = precs[p];
+            int offset_sec = tz_offsets[o];
+            size_t size = time_fmt_iso_batch_size(in, N, offset_sec, prec);
+            size_t n = time_fmt_iso_batch(in, N, offset_sec, prec, buf, size, offsets);
+            assert(n == size);
+            assert(offsets[0] == 0 && offsets[N] == (int32_t)n);
+            for (size_t i = 0; i < N; i++) {
+                char want[64];
+                size_t len = time_fmt_iso_prec(in[i], offset_sec, prec, want, sizeof(want));
+                assert((size_t)(offsets[i + 1] - offsets[i]) == len);
+                assert(memcmp(buf + offsets[i], want, len) == 0);
+            }
+
+            // The buffer is too small.
+            assert(time_fmt_iso_batch(in, N, offset_sec, prec, buf, size - 1, offsets) == 0);
+
+            // Fixed width, without the rows with years outside 0000-9999.
+            if (prec < 0) {
+                assert(time_fmt_iso_batch(in, N - 3, offset_sec, prec, buf, size, NULL) == 0);
+                continue;
+            }
+            n = time_fmt_iso_batch(in, N - 3, offset_sec, prec, buf, size, NULL);
+            size_t width = n / (N - 3);
+            assert(n == time_fmt_iso_batch_size(in, N - 3, offset_sec, prec));
+            for (size_t i = 0; i < N - 3; i++) {
+                char want[64];
+                assert(time_fmt_iso_prec(in[i], offset_sec, prec, want, sizeof(want)) == width);
+                assert(memcmp(buf + i * width, want, width) == 0);
+            }
+            assert(time_fmt_iso_batch(in, N, offset_sec, prec, buf, size, NULL) == 0);
+        }
+    }
+    printf("OK\n");
+}
+
 FormatTest fmt_dt_tests[] = {
     {2011, 11, 18, 15, 56, 35, 0, "2011-11-18 15:56:35", 0},
     {2011, 11, 18, 15, 56, 35, 666777888, "2011-11-18 15:56:35", 0},
@@ -112,6 +283,29 @@ static void test_fmt_time(void) {
     printf("OK\n");
 }
 
+static void test_fmt_truncate(void) {
+    printf("test_fmt_truncate...");
+    Time t = time_date(2011, 11, 18, 15, 56, 35, 666777888, 0);
+    const char* want = "2011-11-18T20:56:35.666777888+05:00";
+    size_t want_n = strlen(want);
+    for (size_t size = 0; size <= want_n + 1; size++) {
+        char got[64];
+        memset(got, 'x', sizeof(got));
+        size_t n = time_fmt_iso(t, 5 * 3600, got, size);
+        // Like snprintf: return the full length, write at most size-1 characters.
+        assert(n == want_n);
+        if (size == 0) {
+            assert(got[0] == 'x');
+            continue;
+        }
+        size_t m = size - 1 < want_n ? size - 1 : want_n;
+        assert(strncmp(got, want, m) == 0);
+        assert(got[m] == '\0');
+        assert(got[m + 1] == 'x');
+    }
+    printf("OK\n");
+}
+
 FormatTest parse_tests[] = {
     {2011, 11, 18, 15, 56, 35, 0, "2011-11-18T15:56:35Z", 0},
     {2011, 11, 18, 15, 56, 35, 666777888, "2011-11-18T15:56:35.666777888Z", 0},
@@ -121,12 +315,155 @@ FormatTest parse_tests[] = {
     {2011, 11, 18, 15, 56, 35, 0, "2011-11-18T10:26:35-05:30", -5 * 3600 - 30 * 60},
     {2011, 11, 18, 15, 56, 35, 666777888, "2011-11-18T20:56:35.666777888+05:00", 5 * 3600},
     {2011, 11, 18, 15, 56, 35, 666777888, "2011-11-18T10:56:35.666777888-05:00", -5 * 3600},
+    {2011, 11, 18, 15, 56, 35, 600000000, "2011-11-18T15:56:35.6Z", 0},
+    {2011, 11, 18, 15, 56, 35, 666000000, "2011-11-18T15:56:35.666Z", 0},
+    {2011, 11, 18, 15, 56, 35, 666777000, "2011-11-18T15:56:35.666777Z", 0},
+    {2011, 11, 18, 15, 56, 35, 66000000, "2011-11-18T20:56:35.066+05:00", 5 * 3600},
     {2011, 11, 18, 15, 56, 35, 0, "2011-11-18 15:56:35", 0},
+    {2011, 11, 18, 15, 56, 35, 0, "2011-11-18T15:56:35", 0},
     {2011, 11, 18, 0, 0, 0, 0, "2011-11-18", 0},
     {1, 1, 1, 15, 56, 35, 0, "15:56:35", 0},
     {1, 1, 1, 0, 0, 0, 0, "2011-11-18 10:56", 0},
 };
 
+typedef struct {
+    const char* name;
+    const char* layout;
+    const char* want;
+} LayoutTest;
+
+// Formatted in UTC-8 (Go formats the reference time in PST).
+static LayoutTest fmt_layout_tests[] = {
+    {"ANSIC", "Mon Jan _2 15:04:05 2006", "Wed Feb  4 21:00:57 2009"},
+    {"UnixDate", "Mon Jan _2 15:04:05 MST 2006", "Wed Feb  4 21:00:57 -0800 2009"},
+    {"RubyDate", "Mon Jan 02 15:04:05 -0700 2006", "Wed Feb 04 21:00:57 -0800 2009"},
+    {"RFC822", "02 Jan 06 15:04 MST", "04 Feb 09 21:00 -0800"},
+    {"RFC850", "Monday, 02-Jan-06 15:04:05 MST", "Wednesday, 04-Feb-09 21:00:57 -0800"},
+    {"RFC1123", "Mon, 02 Jan 2006 15:04:05 MST", "Wed, 04 Feb 2009 21:00:57 -0800"},
+    {"RFC1123Z", "Mon, 02 Jan 2006 15:04:05 -0700", "Wed, 04 Feb 2009 21:00:57 -0800"},
+    {"RFC3339", "2006-01-02T15:04:05Z07:00", "2009-02-04T21:00:57-08:00"},
+    {"RFC3339Nano", "2006-01-02T15:04:05.999999999Z07:00", "2009-02-04T21:00:57.0123456-08:00"},
+    {"Kitchen", "3:04PM", "9:00PM"},
+    {"am/pm", "3pm", "9pm"},
+    {"AM/PM", "3PM", "9PM"},
+    {"two-digit year", "06 01 02", "09 02 04"},
+    {"Janet", "Hi Janet, the Month is January", "Hi Janet, the Month is February"},
+    {"Stamp", "Jan _2 15:04:05", "Feb  4 21:00:57"},
+    {"StampMilli", "Jan _2 15:04:05.000", "Feb  4 21:00:57.012"},
+    {"StampMicro", "Jan _2 15:04:05.000000", "Feb  4 21:00:57.012345"},
+    {"StampNano", "Jan _2 15:04:05.000000000", "Feb  4 21:00:57.012345600"},
+    {"DateTime", "2006-01-02 15:04:05", "2009-02-04 21:00:57"},
+    {"DateOnly", "2006-01-02", "2009-02-04"},
+    {"TimeOnly", "15:04:05", "21:00:57"},
+    {"YearDay", "Jan  2 002 __2 2", "Feb  4 035  35 4"},
+    {"Year", "2006 6 06 _6 __6 ___6", "2009 6 09 _6 __6 ___6"},
+    {"Month", "Jan January 1 01 _1", "Feb February 2 02 _2"},
+    {"DayOfMonth", "2 02 _2 __2", "4 04  4  35"},
+    {"DayOfWeek", "Mon Monday", "Wed Wednesday"},
+    {"Hour", "15 3 03 _3", "21 9 09 _9"},
+    {"Minute", "4 04 _4", "0 00 _0"},
+    {"Second", "5 05 _5", "57 57 _57"},
+    {"Comma", "15:04:05,000", "21:00:57,012"},
+    {"Trim", "05.999 05,99", "57.012 57,01"},
+    {"Offsets", "Z07 Z0700 Z070000 -07:00:00", "-08 -0800 -080000 -08:00:00"},
+    {"_2006", "_2006", "_2009"},
+    {"Not a fraction", "05.0001", "57.0002"},
+};
+
+static void test_fmt_layout(void) {
+    printf("test_fmt_layout...");
+    int offset_sec = -8 * 3600;
+    Time t = time_date(2009, TIME_FEBRUARY, 4, 21, 0, 57, 12345600, offset_sec);
+    for (size_t i = 0; i < sizeof(fmt_layout_tests) / sizeof(fmt_layout_tests[0]); i++) {
+        LayoutTest test = fmt_layout_tests[i];
+        TimeLayout layout;
+        assert(time_layout_compile(test.layout, &layout));
+        char got[64];
+        size_t n = time_fmt_layout(t, offset_sec, &layout, got, sizeof(got));
+        // printf("%s: want: %s, got: %s\n", test.name, test.want, got);
+        assert(strcmp(got, test.want) == 0);
+        assert(n == strlen(test.want));
+    }
+    printf("OK\n");
+}
+
+typedef struct {
+    int offset_sec;
+    const char* want;
+} LayoutTZTest;
+
+// Offsets under a minute, formatted with every seconds-bearing timezone token.
+static LayoutTZTest fmt_layout_tz_tests[] = {
+    {-30, "-00:00:30 -00:00:30 -000030 -000030"},
+    {30, "+00:00:30 +00:00:30 +000030 +000030"},
+    {-1, "-00:00:01 -00:00:01 -000001 -000001"},
+    {-59, "-00:00:59 -00:00:59 -000059 -000059"},
+    {-61, "-00:01:01 -00:01:01 -000101 -000101"},
+};
+
+static void test_fmt_layout_tz_seconds(void) {
+    printf("test_fmt_layout_tz_seconds...");
+    TimeLayout layout;
+    assert(time_layout_compile("-07:00:00 Z07:00:00 -070000 Z070000", &layout));
+    Time t = time_date(2009, TIME_FEBRUARY, 4, 21, 0, 57, 0, 0);
+    for (size_t i = 0; i < sizeof(fmt_layout_tz_tests) / sizeof(fmt_layout_tz_tests[0]); i++) {
+        LayoutTZTest test = fmt_layout_tz_tests[i];
+        char got[64];
+        size_t n = time_fmt_layout(t, test.offset_sec, &layout, got, sizeof(got));
+        // printf("%d: want: %s, got: %s\n", test.offset_sec, test.want, got);
+        assert(strcmp(got, test.want) == 0);
+        assert(n == strlen(test.want));
+    }
+    printf("OK\n");
+}
+
+static void test_fmt_layout_utc(void) {
+    printf("test_fmt_layout_utc...");
+    TimeLayout layout;
+    assert(time_layout_compile("2006-01-02T15:04:05.999Z07:00 MST Z07:00:00 -07:00 3PM", &layout));
+    char got[64];
+
+    Time t = time_date(2024, TIME_JANUARY, 1, 0, 5, 0, 0, 0);
+    time_fmt_layout(t, 0, &layout, got, sizeof(got));
+    assert(strcmp(got, "2024-01-01T00:05:00Z UTC Z +00:00 12AM") == 0);
+
+    t = time_date(-5, TIME_MARCH, 1, 12, 0, 0, 500000000, 0);
+    time_fmt_layout(t, 5 * 3600 + 30 * 60, &layout, got, sizeof(got));
+    assert(strcmp(got, "-0005-03-01T17:30:00.5+05:30 +0530 +05:30:00 +05:30 5PM") == 0);
+
+    // Truncates like snprintf.
+    char small[8];
+    size_t n = time_fmt_layout(t, 0, &layout, small, sizeof(small));
+    assert(strcmp(small, "-0005-0") == 0);
+    assert(n == strlen("-0005-03-01T12:00:00.5Z UTC Z +00:00 12PM"));
+    printf("OK\n");
+}
+
+static void test_layout_compile(void) {
+    printf("test_layout_compile...");
+    TimeLayout layout;
+    assert(time_layout_compile("", &layout));
+    assert(layout.nops == 0);
+
+    char text[TIME_LAYOUT_MAX_TEXT + 2];
+    memset(text, 'x', sizeof(text) - 1);
+    text[sizeof(text) - 1] = '\0';
+    assert(!time_layout_compile(text, &layout));  // too much text
+    text[TIME_LAYOUT_MAX_TEXT] = '\0';
+    assert(time_layout_compile(text, &layout));
+
+    char ops[2 * TIME_LAYOUT_MAX_OPS + 2];
+    for (int i = 0; i < TIME_LAYOUT_MAX_OPS; i++) {
+        memcpy(ops + 2 * i, "05", 2);
+    }
+    ops[2 * TIME_LAYOUT_MAX_OPS] = '\0';
+    assert(time_layout_compile(ops, &layout));
+    ops[2 * TIME_LAYOUT_MAX_OPS] = 'x';
+    ops[2 * TIME_LAYOUT_MAX_OPS + 1] = '\0';
+    assert(!time_layout_compile(ops, &layout));  // too many ops
+    printf("OK\n");
+}
+
 static void test_parse(void) {
     printf("test_parse...");
     for (size_t i = 0; i < sizeof(parse_tests) / sizeof(parse_tests[0]); i++) {
@@ -145,12 +482,21 @@ static void test_parse_invalid(void) {
     printf("test_parse_invalid...");
     // Test invalid timezone strings that should return zero time
     const char* invalid_cases[] = {
-        "2011-11-18T15:56:35+0500",   // missing colon
-        "2011-11-18T15:56:35+0X:00",  // non-digit in hours
-        "2011-11-18T15:56:35+00:0X",  // non-digit in minutes
-        "2011-11-18T15:56:35*05:00",  // invalid sign
-        "2011-11-18T15:56:35+05:0",   // too short minutes
-        "2011-11-18T15:56:35+5:00",   // too short hours
+        "2011-11-18T15:56:35+0500",         // missing colon
+        "2011-11-18T15:56:35+0X:00",        // non-digit in hours
+        "2011-11-18T15:56:35+00:0X",        // non-digit in minutes
+        "2011-11-18T15:56:35*05:00",        // invalid sign
+        "2011-11-18T15:56:35+05:0",         // too short minutes
+        "2011-11-18T15:56:35+5:00",         // too short hours
+        "2011-1X-18T15:56:35Z",             // non-digit in month
+        "2011-11-18X15:56:35Z",             // invalid date/time separator
+        "2011-11-18T15:56:35X",             // invalid UTC designator
+        "2011-11-18T15:56:35,666777888Z",   // invalid fraction separator
+        "2011-11-18T15:56:35.66677788XZ",   // non-digit in fraction
+        "2011-11-18T15:56:35.Z",            // empty fraction
+        "2011-11-18T15:56:35.6667778889Z",  // too many fraction digits
+        "15.56.35",                         // invalid clock separator
+        "",                                 // empty string
     };
 
     for (size_t i = 0; i < sizeof(invalid_cases) / sizeof(invalid_cases[0]); i++) {
@@ -160,11 +506,479 @@ static void test_parse_invalid(void) {
     printf("OK\n");
 }
 
+typedef struct {
+    const char* value;
+    size_t len;
+    size_t want_n;
+    const char* want;
+} ParseNTest;
+
+ParseNTest parse_n_tests[] = {
+    {"2011-11-18T15:56:35.666777888+05:00 GET /", 41, 35, "2011-11-18T15:56:35.666777888+05:00"},
+    {"2011-11-18T15:56:35.666777888Z GET /", 36, 30, "2011-11-18T15:56:35.666777888Z"},
+    {"2011-11-18T15:56:35+05:00,next", 30, 25, "2011-11-18T15:56:35+05:00"},
+    {"2011-11-18T15:56:35Z,next", 25, 20, "2011-11-18T15:56:35Z"},
+    {"2011-11-18 15:56:35Z", 20, 20, "2011-11-18T15:56:35Z"},
+    {"2011-11-18 15:56:35|next", 24, 19, "2011-11-18T15:56:35Z"},
+    {"2011-11-18|next", 15, 10, "2011-11-18T00:00:00Z"},
+    {"15:56:35|next", 13, 8, "0001-01-01T15:56:35Z"},
+    // Bounded by len rather than by the NUL terminator.
+    {"2011-11-18T15:56:35.666777888Z", 25, 25, "2011-11-18T15:56:35.66677Z"},
+    {"2011-11-18T15:56:35Z", 19, 19, "2011-11-18T15:56:35Z"},
+    {"2011-11-18T15:56:35Z", 18, 10, "2011-11-18T00:00:00Z"},
+    {"2011-11-18T15:56:35Z", 9, 0, NULL},
+    {"15:56:35", 7, 0, NULL},
+    {"", 0, 0, NULL},
+    // Partially matching suffixes are left unconsumed.
+    {"2011-11-18T15:56:35.666Z", 24, 24, "2011-11-18T15:56:35.666Z"},
+    {"2011-11-18T15:56:35.1234567890Z", 31, 29, "2011-11-18T15:56:35.123456789Z"},
+    {"2011-11-18T15:56:35.Z", 21, 19, "2011-11-18T15:56:35Z"},
+    {"2011-11-18T15:56:35+5:00", 24, 19, "2011-11-18T15:56:35Z"},
+    {"2011-11-18T15:56", 16, 10, "2011-11-18T00:00:00Z"},
+    {"2011-11-1", 9, 0, NULL},
+};
+
+static void test_parse_n(void) {
+    printf("test_parse_n...");
+    for (size_t i = 0; i < sizeof(parse_n_tests) / sizeof(parse_n_tests[0]); i++) {
+        ParseNTest test = parse_n_tests[i];
+        // Copy into an exact-size buffer without a NUL terminator.
+        char buf[64];
+        memcpy(buf, test.value, test.len);
+        Time got = {42, 42};
+        size_t n = time_parse_n(buf, test.len, &got);
+        // printf("%s: want n=%zu, got n=%zu\n", test.value, test.want_n, n);
+        assert(n == test.want_n);
+        if (test.want == NULL) {
+            assert(got.sec == 42 && got.nsec == 42);  // untouched on failure
+            continue;
+        }
+        assert(time_equal(got, time_parse(test.want)));
+    }
+    printf("OK\n");
+}
+
+// parse_mutation_ok reports whether replacing the character at position i
+// of an ISO 8601 string with c keeps the string valid.
+static bool parse_mutation_ok(const char* value, size_t i, int c) {
+    char orig = value[i];
+    if (orig >= '0' && orig <= '9') {
+        return c >= '0' && c <= '9';
+    }
+    if (orig == 'T' || (orig == ' ' && i == 10)) {
+        return c == 'T' || c == ' ';
+    }
+    if (orig == '+' || orig == '-') {
+        return c == orig || (i > 10 && (c == '+' || c == '-'));
+    }
+    return c == orig;
+}
+
+static void test_parse_bytes(void) {
+    printf("test_parse_bytes...");
+    // Replaces each character with every possible byte, so that
+    // all digit and separator checks see every possible input.
+    const char* values[] = {
+        "2011-11-18T15:56:35.666777888+07:00",
+        "2011-11-18T15:56:35.666777888Z",
+        "2011-11-18 15:56:35.6666-01:30",
+        "2011-11-18T15:56:35.6+01:30",
+        "2011-11-18T15:56:35Z",
+        "2011-11-18 15:56:35",
+        "2011-11-18",
+        "15:56:35",
+    };
+    for (size_t k = 0; k < sizeof(values) / sizeof(values[0]); k++) {
+        size_t len = strlen(values[k]);
+        // An exact-size heap buffer, so that the sanitizers catch overreads.
+        char* buf = malloc(len);
+        assert(buf != NULL);
+        for (size_t i = 0; i < len; i++) {
+            for (int c = 0; c < 256; c++) {
+                memcpy(buf, values[k], len);
+                buf[i] = (char)c;
+                Time got = {0, 0};
+                bool ok = time_parse_n(buf, len, &got) == len;
+                // printf("%s[%zu] = %02x: want %d, got %d\n", values[k], i, c,
+                // parse_mutation_ok(values[k], i, c), ok);
+                assert(ok == parse_mutation_ok(values[k], i, c));
+            }
+        }
+        free(buf);
+    }
+    printf("OK\n");
+}
+
+typedef struct {
+    const char* layout;
+    const char* value;
+    size_t want_n;     // bytes consumed, 0 on failure
+    const char* want;  // parsed time in ISO 8601, or the error position on failure
+    size_t err_pos;
+} ParseLayoutTest;
+
+static ParseLayoutTest parse_layout_tests[] = {
+    // Standard layouts.
+    {"Mon Jan _2 15:04:05 2006", "Thu Feb  4 21:00:57 2010", 24, "2010-02-04T21:00:57Z"},
+    {"Mon Jan _2 15:04:05 MST 2006", "Thu Feb  4 21:00:57 UTC 2010", 28, "2010-02-04T21:00:57Z"},
+    {"Mon Jan 02 15:04:05 -0700 2006", "Thu Feb 04 21:00:57 -0800 2010", 30,
+     "2010-02-05T05:00:57Z"},
+    {"Mon, 02 Jan 2006 15:04:05 MST", "Thu, 04 Feb 2010 21:00:57 GMT", 29, "2010-02-04T21:00:57Z"},
+    {"Mon, 02 Jan 2006 15:04:05 MST", "Thu, 04 Feb 2010 21:00:57 -0800", 31,
+     "2010-02-05T05:00:57Z"},
+    {"Monday, 02-Jan-06 15:04:05 MST", "Thursday, 04-Feb-10 21:00:57 UTC", 32,
+     "2010-02-04T21:00:57Z"},
+    {"2006-01-02T15:04:05Z07:00", "2010-02-04T21:00:57-08:00", 25, "2010-02-05T05:00:57Z"},
+    {"2006-01-02T15:04:05Z07:00", "2010-02-04T21:00:57Z", 20, "2010-02-04T21:00:57Z"},
+    {"02/Jan/2006:15:04:05 -0700", "04/Feb/2010:21:00:57 -0800", 26, "2010-02-05T05:00:57Z"},
+    {"3:04PM", "9:00PM", 6, "0001-01-01T21:00:00Z"},
+    {"3:04pm", "12:30am", 7, "0001-01-01T00:30:00Z"},
+    {"03:04 PM", "12:30 PM", 8, "0001-01-01T12:30:00Z"},
+    {"06-1-2", "99-2-4", 6, "1999-02-04T00:00:00Z"},
+    {"06-1-2", "68-12-31", 8, "2068-12-31T00:00:00Z"},
+
+    // Names are case-insensitive.
+    {"Jan 2 2006", "FEB 4 2010", 10, "2010-02-04T00:00:00Z"},
+    {"January 2 2006", "february 4 2010", 15, "2010-02-04T00:00:00Z"},
+
+    // Fractional seconds.
+    {"Jan _2 15:04:05.000", "Feb  4 21:00:57.012", 19, "0001-02-04T21:00:57.012000000Z"},
+    {"15:04:05,000000", "21:00:57,012345", 15, "0001-01-01T21:00:57.012345000Z"},
+    {"15:04:05.999", "21:00:57", 8, "0001-01-01T21:00:57Z"},
+    {"15:04:05.999", "21:00:57.5", 10, "0001-01-01T21:00:57.500000000Z"},
+    {"15:04:05.999Z07:00", "21:00:57.123456789-01:00", 24, "0001-01-01T22:00:57.123456789Z"},
+    {"15:04:05", "21:00:57.0123456", 16, "0001-01-01T21:00:57.012345600Z"},
+    {"15:04:05", "21:00:57.0123456789999", 22, "0001-01-01T21:00:57.012345678Z"},
+
+    // Day of the year.
+    {"2006 002", "2024 060", 8, "2024-02-29T00:00:00Z"},
+    {"2006 __2", "2023  60", 8, "2023-03-01T00:00:00Z"},
+    {"2006-01-02 002", "2024-02-29 060", 14, "2024-02-29T00:00:00Z"},
+
+    // Timezone offsets.
+    {"15:04 Z07", "21:00 +05", 9, "0001-01-01T16:00:00Z"},
+    {"15:04 -070000", "21:00 +053015", 13, "0001-01-01T15:29:45Z"},
+    {"15:04 Z07:00:00", "21:00 -05:30:15", 15, "0001-01-02T02:30:15Z"},
+
+    // Trailing text is not consumed.
+    {"2006-01-02", "2010-02-04 21:00", 10, "2010-02-04T00:00:00Z"},
+
+    // Errors.
+    {"2006-01-02", "2010-13-01", 0, NULL, 5},           // month out of range
+    {"2006-01-02", "2010-02-0x", 0, NULL, 8},           // not a number
+    {"2006-01-02", "2010/02/04", 0, NULL, 4},           // literal mismatch
+    {"2006-01-02", "2023-02-29", 0, NULL, 8},           // day out of range
+    {"2006-01-02", "2010-02", 0, NULL, 7},              // too short
+    {"2006-01-02", "10-02-04", 0, NULL, 0},             // two-digit year
+    {"15:04:05", "24:00:00", 0, NULL, 0},               // hour out of range
+    {"15:04:05", "23:60:00", 0, NULL, 3},               // minute out of range
+    {"3:04PM", "13:00PM", 0, NULL, 0},                  // hour12 out of range
+    {"3:04PM", "1:00XM", 0, NULL, 4},                   // not AM/PM
+    {"Jan 2", "Foo 2", 0, NULL, 0},                     // not a month
+    {"Mon Jan 2", "Thx Feb 4", 0, NULL, 0},             // not a weekday
+    {"15:04:05.000", "21:00:57.01", 0, NULL, 8},        // too few fraction digits
+    {"15:04 MST", "21:00 PST", 0, NULL, 6},             // unknown zone
+    {"15:04 -07:00", "21:00 Z", 0, NULL, 6},            // Z needs a Z07:00 layout
+    {"15:04 -07:00", "21:00 +0500", 0, NULL, 6},        // missing colon
+    {"2006 002", "2023 366", 0, NULL, 5},               // not a leap year
+    {"2006-01-02 002", "2024-03-01 060", 0, NULL, 11},  // day of year mismatch
+};
+
+static void test_parse_layout(void) {
+    printf("test_parse_layout...");
+    for (size_t i = 0; i < sizeof(parse_layout_tests) / sizeof(parse_layout_tests[0]); i++) {
+        ParseLayoutTest test = parse_layout_tests[i];
+        TimeLayout layout;
+        assert(time_layout_compile(test.layout, &layout));
+        // Copy into an exact-size buffer without a NUL terminator.
+        char buf[64];
+        size_t len = strlen(test.value);
+        memcpy(buf, test.value, len);
+        Time got = {42, 42};
+        size_t err_pos = 42;
+        size_t n = time_parse_layout(buf, len, &layout, &got, &err_pos);
+        // printf("%s: want n=%zu, got n=%zu\n", test.value, test.want_n, n);
+        assert(n == test.want_n);
+        if (test.want == NULL) {
+            assert(got.sec == 42 && got.nsec == 42);  // untouched on failure
+            assert(err_pos == test.err_pos);
+            continue;
+        }
+        assert(err_pos == 42);
+        char iso[64];
+        time_fmt_iso(got, 0, iso, sizeof(iso));
+        assert(strcmp(iso, test.want) == 0);
+    }
+    printf("OK\n");
+}
+
+static void test_parse_layout_roundtrip(void) {
+    printf("test_parse_layout_roundtrip...");
+    const char* layouts[] = {
+        "2006-01-02T15:04:05.999999999Z07:00",
+        "Mon, 02 Jan 2006 15:04:05.000000000 -0700",
+        "Monday January _2 2006 3:04:05.000000000PM Z070000",
+        "06/01/02 15:04:05,000000000 MST",
+    };
+    int offsets[] = {0, 3600, -5 * 3600 - 30 * 60};
+    Time t = time_date(1999, TIME_DECEMBER, 31, 23, 59, 59, 123456789, 0);
+    for (size_t i = 0; i < sizeof(layouts) / sizeof(layouts[0]); i++) {
+        TimeLayout layout;
+        assert(time_layout_compile(layouts[i], &layout));
+        for (size_t j = 0; j < sizeof(offsets) / sizeof(offsets[0]); j++) {
+            for (int k = 0; k < 100; k++) {
+                Time u = time_add(t, (Duration)k * 797 * TIME_HOUR);
+                char buf[64];
+                size_t n = time_fmt_layout(u, offsets[j], &layout, buf, sizeof(buf));
+                Time got = {0, 0};
+                assert(time_parse_layout(buf, n, &layout, &got, NULL) == n);
+                assert(time_equal(got, u));
+            }
+        }
+    }
+    printf("OK\n");
+}
+
+// parse_batch_check checks the batch parsing results against time_parse.
+static void parse_batch_check(const char* const* strs,
+                              size_t n,
+                              const Time* got,
+                              const uint8_t* valid,
+                              size_t count) {
+    size_t want_count = 0;
+    for (size_t i = 0; i < n; i++) {
+        Time want = time_parse(strs[i]);
+        bool ok = !time_is_zero(want) || strcmp(strs[i], "0001-01-01T00:00:00Z") == 0;
+        assert(time_equal(got[i], want));
+        assert(((valid[i / 8] >> (i % 8)) & 1) == ok);
+        want_count += ok;
+    }
+    assert(count == want_count);
+}
+
+static void test_parse_batch(void) {
+    printf("test_parse_batch...");
+    // Rows of different lengths, some of them invalid.
+    const char* mixed[] = {
+        "2011-11-18T15:56:35.666777888+07:00",
+        "2011-11-18T15:56:35Z",
+        "2011-11-18 15:56:35",
+        "2011-11-18",
+        "15:56:35",
+        "0001-01-01T00:00:00Z",
+        "",
+        "2011-11-18T15:56:35+07",
+        "2011-11-18T15:56:35.666Z",
+        "2011-11-18T15:56:35.1234567890Z",
+        "not a time",
+        "2011-11-18x",
+    };
+    size_t n = sizeof(mixed) / sizeof(mixed[0]);
+    size_t lens[sizeof(mixed) / sizeof(mixed[0])];
+    for (size_t i = 0; i < n; i++) {
+        lens[i] = strlen(mixed[i]);
+    }
+    Time got[sizeof(mixed) / sizeof(mixed[0])];
+    uint8_t valid[2];
+    size_t count = time_parse_batch(mixed, lens, n, got, valid);
+    parse_batch_check(mixed, n, got, valid, count);
+    assert(count == 7);
+    assert(valid[1] == 0x01);  // high bits are zero
+
+    // Rows of the same length, spanning several chunks. Some rows
+    // have the same length but a different layout than the first one.
+    enum { N = 1000 };
+    static char bufs[N][26];
+    static const char* strs[N];
+    static size_t same_lens[N];
+    Time t = time_date(1999, TIME_DECEMBER, 31, 23, 59, 59, 123400000, 0);
+    for (size_t i = 0; i < N; i++) {
+        Time u = time_add(t, (Duration)i * 7919 * TIME_SECOND);
+        if (i % 10 == 7) {
+            time_fmt_iso(time_truncate(u, TIME_SECOND), 3600, bufs[i], sizeof(bufs[i]));
+        } else {
+            time_fmt_iso_prec(u, 0, 4, bufs[i], sizeof(bufs[i]));
+        }
+        if (i % 13 == 5) {
+            bufs[i][i % 25] = '?';
+        }
+        strs[i] = bufs[i];
+        same_lens[i] = 25;
+    }
+    static Time same_got[N];
+    static uint8_t same_valid[(N + 7) / 8];
+    count = time_parse_batch(strs, same_lens, N, same_got, same_valid);
+    parse_batch_check(strs, N, same_got, same_valid, count);
+
+    // The valid bitmap is optional.
+    assert(time_parse_batch(strs, same_lens, N, same_got, NULL) == count);
+
+    // NULL strings are invalid.
+    const char* nulls[] = {"2011-11-18", NULL};
+    size_t null_lens[] = {10, 0};
+    assert(time_parse_batch(nulls, null_lens, 2, got, valid) == 1);
+    assert(valid[0] == 0x01);
+    printf("OK\n");
+}
+
+static void test_parse_batch_offsets(void) {
+    printf("test_parse_batch_offsets...");
+    const char* strs[] = {
+        "2011-11-18T15:56:35Z", "2011-11-18T15:56:35Z", "2011-11-18T15:56:3?Z",
+        "2011-11-18T15:56:35Z", "2011-11-18",           "15:56:35",
+        "2011-11-18 15:56:35",  "",                     "2011-11-18T15:56:35.5-01:30",
+    };
+    size_t n = sizeof(strs) / sizeof(strs[0]);
+    char data[256];
+    int32_t offsets[sizeof(strs) / sizeof(strs[0]) + 1];
+    offsets[0] = 0;
+    for (size_t i = 0; i < n; i++) {
+        size_t len = strlen(strs[i]);
+        memcpy(data + offsets[i], strs[i], len);
+        offsets[i + 1] = offsets[i] + (int32_t)len;
+    }
+    Time got[sizeof(strs) / sizeof(strs[0])];
+    uint8_t valid[2];
+    size_t count = time_parse_batch_offsets(data, offsets, n, got, valid);
+    parse_batch_check(strs, n, got, valid, count);
+    assert(count == 7);
+    printf("OK\n");
+}
+
+static void test_fmt_http(void) {
+    printf("test_fmt_http...");
+    struct {
+        Time t;
+        const char* want;
+    } tests[] = {
+        {time_date(1994, TIME_NOVEMBER, 6, 8, 49, 37, 0, 0), "Sun, 06 Nov 1994 08:49:37 GMT"},
+        {time_date(2011, TIME_NOVEMBER, 18, 15, 56, 35, 666777888, 0),
+         "Fri, 18 Nov 2011 15:56:35 GMT"},
+        {time_date(2011, TIME_NOVEMBER, 18, 15, 56, 35, 0, 3600), "Fri, 18 Nov 2011 14:56:35 GMT"},
+        {time_date(1, TIME_JANUARY, 1, 0, 0, 0, 0, 0), "Mon, 01 Jan 0001 00:00:00 GMT"},
+        {time_date(9999, TIME_DECEMBER, 31, 23, 59, 59, 0, 0), "Fri, 31 Dec 9999 23:59:59 GMT"},
+    };
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        char got[64];
+        size_t n = time_fmt_http(tests[i].t, got, sizeof(got));
+        assert(n == strlen(tests[i].want));
+        assert(strcmp(got, tests[i].want) == 0);
+        Time parsed;
+        assert(time_parse_http(got, n, &parsed) == n);
+        assert(time_equal(parsed, time_truncate(tests[i].t, TIME_SECOND)));
+    }
+    char got[10];
+    assert(time_fmt_http(tests[0].t, got, sizeof(got)) == 29);
+    assert(strcmp(got, "Sun, 06 N") == 0);
+    printf("OK\n");
+}
+
+static void test_fmt_http_cached(void) {
+    printf("test_fmt_http_cached...");
+    Time t = time_date(1994, TIME_NOVEMBER, 6, 8, 49, 37, 0, 0);
+    for (int i = 0; i < 1000; i++) {
+        // Mostly within the same second, sometimes going back in time.
+        t = time_add(t, (Duration)(i % 7 == 6 ? -3 : 1) * 123456789);
+        char want[64], got[64];
+        size_t want_n = time_fmt_http(t, want, sizeof(want));
+        assert(time_fmt_http_cached(t, got, sizeof(got)) == want_n);
+        assert(strcmp(got, want) == 0);
+    }
+    char got[10];
+    assert(time_fmt_http_cached(t, got, sizeof(got)) == 29);
+    assert(strlen(got) == 9);
+    printf("OK\n");
+}
+
+typedef struct {
+    const char* value;
+    size_t want_n;     // bytes consumed, 0 on failure
+    const char* want;  // parsed time in ISO 8601
+} ParseHTTPTest;
+
+static ParseHTTPTest parse_http_tests[] = {
+    // The three formats allowed by RFC 7231.
+    {"Sun, 06 Nov 1994 08:49:37 GMT", 29, "1994-11-06T08:49:37Z"},
+    {"Sunday, 06-Nov-94 08:49:37 GMT", 30, "1994-11-06T08:49:37Z"},
+    {"Sun Nov  6 08:49:37 1994", 24, "1994-11-06T08:49:37Z"},
+    {"Thu Nov 16 08:49:37 1994", 24, "1994-11-16T08:49:37Z"},
+    // Names are case-insensitive, and the weekday is ignored.
+    {"sun, 06 nov 1994 08:49:37 GMT", 29, "1994-11-06T08:49:37Z"},
+    {"Mon, 06 Nov 1994 08:49:37 GMT", 29, "1994-11-06T08:49:37Z"},
+    // Two-digit years.
+    {"Sunday, 01-Jan-68 00:00:00 GMT", 30, "2068-01-01T00:00:00Z"},
+    {"Sunday, 01-Jan-69 00:00:00 GMT", 30, "1969-01-01T00:00:00Z"},
+    // Trailing data is not consumed.
+    {"Sun, 06 Nov 1994 08:49:37 GMT; foo", 29, "1994-11-06T08:49:37Z"},
+    {"Sun, 29 Feb 2000 00:00:00 GMT", 29, "2000-02-29T00:00:00Z"},
+    // Invalid dates.
+    {"", 0, NULL},
+    {"Sun", 0, NULL},
+    {"Sun,", 0, NULL},
+    {"Xyz, 06 Nov 1994 08:49:37 GMT", 0, NULL},
+    {"Sun, 6 Nov 1994 08:49:37 GMT", 0, NULL},
+    {"Sun, 06 Nov 94 08:49:37 GMT", 0, NULL},
+    {"Sun, 06 Xyz 1994 08:49:37 GMT", 0, NULL},
+    {"Sun, 06 Nov 1994 08:49:37 UTC", 0, NULL},
+    {"Sun, 06 Nov 1994 08:49:37 GM", 0, NULL},
+    {"Sun, 06 Nov 1994 8:49:37 GMT", 0, NULL},
+    {"Sun, 31 Nov 1994 08:49:37 GMT", 0, NULL},
+    {"Sun, 29 Feb 1900 08:49:37 GMT", 0, NULL},
+    {"Sun, 06 Nov 1994 24:00:00 GMT", 0, NULL},
+    {"Sun, 06 Nov 1994 08:60:00 GMT", 0, NULL},
+    {"Sun, 06 Nov 1994 08:49:60 GMT", 0, NULL},
+    {"Sunday, 06-Nov-1994 08:49:37 GMT", 0, NULL},
+    {"Sun, 06-Nov-94 08:49:37 GMT", 0, NULL},
+    {"Sun Nov 6 08:49:37 1994", 0, NULL},
+    {"Sun Nov  6 08:49:37 94", 0, NULL},
+};
+
+static void test_parse_http(void) {
+    printf("test_parse_http...");
+    for (size_t i = 0; i < sizeof(parse_http_tests) / sizeof(parse_http_tests[0]); i++) {
+        ParseHTTPTest test = parse_http_tests[i];
+        // An exact-size heap buffer without a NUL terminator.
+        size_t len = strlen(test.value);
+        char* buf = malloc(len > 0 ? len : 1);
+        assert(buf != NULL);
+        memcpy(buf, test.value, len);
+        Time got = {42, 42};
+        size_t n = time_parse_http(buf, len, &got);
+        free(buf);
+        // printf("%s: want n=%zu, got n=%zu\n", test.value, test.want_n, n);
+        assert(n == test.want_n);
+        if (test.want == NULL) {
+            assert(got.sec == 42 && got.nsec == 42);  // untouched on failure
+            continue;
+        }
+        assert(time_equal(got, time_parse(test.want)));
+    }
+    printf("OK\n");
+}
+
 int main(void) {
     test_fmt_iso();
+    test_fmt_iso_prec();
+    test_fmt_iso_roundtrip();
+    test_fmt_iso_batch();
+    test_fmt_iso_cached();
     test_fmt_datetime();
     test_fmt_date();
     test_fmt_time();
+    test_fmt_truncate();
+    test_layout_compile();
+    test_fmt_layout();
+    test_fmt_layout_tz_seconds();
+    test_fmt_layout_utc();
     test_parse();
     test_parse_invalid();
+    test_parse_n();
+    test_parse_bytes();
+    test_parse_layout();
+    test_parse_layout_roundtrip();
+    test_parse_batch();
+    test_parse_batch_offsets();
+    test_fmt_http();
+    test_fmt_http_cached();
+    test_parse_http();
 }
@@ -7,6 +7,7 @@
 // Time tests.
 
 #include <assert.h>
+#include <limits.h>
 #include <math.h>
 #include <stdbool.h>
 #include <stdint.h>
@@ -85,6 +86,78 @@ static void test_date(void) {
     printf("OK\n");
 }
 
+// batch_size is the number of rows in the batch test fixtures.
+enum { batch_size = 1000 };
+
+// batch_sizes are the lengths the batch tests run with:
+// empty, partial and multi-chunk batches.
+static const size_t batch_sizes[] = {0, 1, 7, 8, 9, 333, 999, batch_size};
+
+// batch_rand returns the next value of the fixed pseudo-random sequence
+// in *x, so the batch fixtures are the same on every run.
+static uint64_t batch_rand(uint64_t* x) {
+    *x = *x * 6364136223846793005ULL + 1442695040888963407ULL;
+    return *x;
+}
+
+// date_batch_input fills the columns with n rows: the date_tests rows, mostly
+// normalized values, some denormalized ones and some extreme years.
+static void date_batch_input(int (*cols)[8], size_t n) {
+    size_t ntests = sizeof(date_tests) / sizeof(date_tests[0]);
+    uint64_t x = 42;
+    for (size_t i = 0; i < n; i++) {
+        int r = (int)(batch_rand(&x) >> 33);
+        int* col = cols[i];
+        if (i < ntests) {
+            DateTest test = date_tests[i];
+            int row[8] = {test.year, test.month, test.day,  test.hour,
+                          test.min,  test.sec,   test.nsec, test.offset_sec};
+            memcpy(col, row, sizeof(row));
+        } else if (i % 13 == 0) {
+            int row[8] = {1900 + r % 300, r % 40 - 20,    r % 100 - 50,  r % 60 - 30,
+                          r % 200 - 100,  r % 200 - 100,  r - (1 << 30), r % 200000 - 100000};
+            memcpy(col, row, sizeof(row));
+        } else {
+            int row[8] = {1900 + r % 300, 1 + r % 12,     1 + r % 28,     r % 24,
+                          r % 60,         r % 60,         r % 1000000000, r % 100000 - 50000};
+            memcpy(col, row, sizeof(row));
+        }
+        if (i % 101 == 0) {
+            col[0] = i % 2 ? INT_MAX - r % 1000 : INT_MIN + r % 1000;
+        }
+    }
+}
+
+static void test_date_batch(void) {
+    printf("test_date_batch...");
+    enum { n = batch_size };
+    static int cols[n][8];
+    static int year[n], month[n], day[n], hour[n], min[n], sec[n], nsec[n], offset_sec[n];
+    static Time out[n];
+    date_batch_input(cols, n);
+    for (size_t i = 0; i < n; i++) {
+        year[i] = cols[i][0], month[i] = cols[i][1], day[i] = cols[i][2];
+        hour[i] = cols[i][3], min[i] = cols[i][4], sec[i] = cols[i][5];
+        nsec[i] = cols[i][6], offset_sec[i] = cols[i][7];
+    }
+    for (size_t j = 0; j < sizeof(batch_sizes) / sizeof(batch_sizes[0]); j++) {
+        size_t k = batch_sizes[j];
+        time_date_batch(year, month, day, hour, min, sec, nsec, offset_sec, 0, k, out);
+        for (size_t i = 0; i < k; i++) {
+            Time want = time_date(year[i], month[i], day[i], hour[i], min[i], sec[i], nsec[i],
+                                  offset_sec[i]);
+            assert(time_equal(out[i], want));
+        }
+    }
+    // Missing clock columns and a shared offset.
+    time_date_batch(year, month, day, NULL, NULL, NULL, NULL, NULL, 3 * 3600, n, out);
+    for (size_t i = 0; i < n; i++) {
+        Time want = time_date(year[i], month[i], day[i], 0, 0, 0, 0, 3 * 3600);
+        assert(time_equal(out[i], want));
+    }
+    printf("OK\n");
+}
+
 // ## Time parts
 
 static TimeTest unix_tests[] = {
@@ -94,6 +167,7 @@ static TimeTest unix_tests[] = {
     {-11644473600, 0, {1601, TIME_JANUARY, 1, 0, 0, 0, 0, TIME_MONDAY}},
     {599529660, 0, {1988, TIME_DECEMBER, 31, 0, 1, 0, 0, TIME_SATURDAY}},
     {978220860, 0, {2000, TIME_DECEMBER, 31, 0, 1, 0, 0, TIME_SUNDAY}},
+    {1709288430, 0, {2024, TIME_MARCH, 1, 10, 20, 30, 0, TIME_FRIDAY}},
     {0, 1e8, {1970, TIME_JANUARY, 1, 0, 0, 0, 1e8, TIME_THURSDAY}},
     {1221681866, 2e8, {2008, TIME_SEPTEMBER, 17, 20, 4, 26, 2e8, TIME_WEDNESDAY}},
 };
@@ -247,6 +321,211 @@ static void test_get_yearday(void) {
     printf("OK\n");
 }
 
+static void test_get_fields(void) {
+    printf("test_get_fields...");
+    for (size_t i = 0; i < sizeof(unix_tests) / sizeof(unix_tests[0]); i++) {
+        TimeTest test = unix_tests[i];
+        Time t = time_unix(test.sec, test.nsec);
+        TimeFields f;
+        time_get_fields(t, &f);
+        assert(f.year == test.golden.year);
+        assert(f.month == test.golden.month);
+        assert(f.day == test.golden.day);
+        assert(f.hour == test.golden.hour);
+        assert(f.min == test.golden.min);
+        assert(f.sec == test.golden.sec);
+        assert(f.nsec == test.golden.nsec);
+        assert(f.weekday == test.golden.weekday);
+    }
+    for (size_t i = 0; i < sizeof(isoweek_tests) / sizeof(isoweek_tests[0]); i++) {
+        ISOWeekTest test = isoweek_tests[i];
+        Time t = time_date(test.year, test.month, test.day, 0, 0, 0, 0, 0);
+        TimeFields f;
+        time_get_fields(t, &f);
+        assert(f.iso_year == test.yex && f.iso_week == test.wex);
+    }
+    for (size_t i = 0; i < sizeof(yearday_tests) / sizeof(yearday_tests[0]); i++) {
+        YearDayTest test = yearday_tests[i];
+        Time t = time_date(test.year, test.month, test.day, 0, 0, 0, 0, 0);
+        TimeFields f;
+        time_get_fields(t, &f);
+        assert(f.yday == test.yday);
+    }
+    // Every 7 hours over several years must agree with the individual getters.
+    Time t = time_date(1999, TIME_DECEMBER, 1, 0, 0, 0, 0, 0);
+    Time end = time_date(2006, TIME_FEBRUARY, 1, 0, 0, 0, 0, 0);
+    for (; time_before(t, end); t = time_add(t, 7 * TIME_HOUR)) {
+        TimeFields f;
+        time_get_fields(t, &f);
+        int year, day, hour, min, sec, iso_year, iso_week;
+        enum Month month;
+        time_get_date(t, &year, &month, &day);
+        time_get_clock(t, &hour, &min, &sec);
+        time_get_isoweek(t, &iso_year, &iso_week);
+        assert(f.year == year && f.month == month && f.day == day);
+        assert(f.yday == time_get_yearday(t) && f.weekday == time_get_weekday(t));
+        assert(f.hour == hour && f.min == min && f.sec == sec);
+        assert(f.iso_year == iso_year && f.iso_week == iso_week);
+    }
+    printf("OK\n");
+}
+
+// ref_days_since_epoch and ref_date are the cycle-cascade calendar
+// algorithms that preceded the current ones, kept as a reference.
+// Both count days from January 1 of the absolute zero year.
+static const int64_t ref_absolute_zero_year = -292277022399LL;
+static const uint64_t ref_internal_to_absolute = 9223371966579724800ULL;
+
+static uint64_t ref_days_since_epoch(int year) {
+    uint64_t y = year - ref_absolute_zero_year;
+    uint64_t n = y / 400;
+    y -= 400 * n;
+    uint64_t d = (365 * 400 + 97) * n;
+    n = y / 100;
+    y -= 100 * n;
+    d += (365 * 100 + 24) * n;
+    n = y / 4;
+    y -= 4 * n;
+    d += (365 * 4 + 1) * n;
+    return d + 365 * y;
+}
+
+static void ref_date(uint64_t d, int* year, int* month, int* day, int* yday) {
+    static const int days_before[] = {0,   31,  59,  90,  120, 151, 181,
+                                      212, 243, 273, 304, 334, 365};
+    uint64_t n = d / (365 * 400 + 97);
+    uint64_t y = 400 * n;
+    d -= (365 * 400 + 97) * n;
+    n = d / (365 * 100 + 24);
+    n -= n >> 2;
+    y += 100 * n;
+    d -= (365 * 100 + 24) * n;
+    n = d / (365 * 4 + 1);
+    y += 4 * n;
+    d -= (365 * 4 + 1) * n;
+    n = d / 365;
+    n -= n >> 2;
+    y += n;
+    d -= 365 * n;
+    *year = y + ref_absolute_zero_year;
+    *yday = d;
+
+    *day = *yday;
+    bool leap = *year % 4 == 0 && (*year % 100 != 0 || *year % 400 == 0);
+    if (leap) {
+        if (*day > 31 + 29 - 1) {
+            *day -= 1;
+        } else if (*day == 31 + 29 - 1) {
+            *month = 2;
+            *day = 29;
+            return;
+        }
+    }
+    *month = *day / 31;
+    int end = days_before[*month + 1];
+    int begin;
+    if (*day >= end) {
+        *month += 1;
+        begin = end;
+    } else {
+        begin = days_before[*month];
+    }
+    *month += 1;
+    *day = *day - begin + 1;
+}
+
+static void test_calendar_sweep(void) {
+    printf("test_calendar_sweep...");
+    // Every day from year -100000 to 100000 must match the reference algorithm,
+    // both when decomposing a time value and when constructing one.
+    Time t = time_date(-100000, TIME_JANUARY, 1, 12, 0, 0, 0, 0);
+    Time end = time_date(100000, TIME_DECEMBER, 31, 12, 0, 0, 0, 0);
+    uint64_t d = (t.sec + ref_internal_to_absolute) / (24 * 60 * 60);
+    assert(d == ref_days_since_epoch(-100000));
+    int year = 0, month = 0, day = 0, yday = 0;
+    for (; !time_after(t, end); t.sec += 24 * 60 * 60, d++) {
+        ref_date(d, &year, &month, &day, &yday);
+        if (month == 1 && day == 1) {
+            assert(d == ref_days_since_epoch(year));
+        }
+        TimeFields f;
+        time_get_fields(t, &f);
+        assert(f.year == year && (int)f.month == month && f.day == day && f.yday == yday + 1);
+        assert(time_equal(time_date(year, month, day, 12, 0, 0, 0, 0), t));
+    }
+    assert(year == 100000 && month == 12 && day == 31);
+    printf("OK\n");
+}
+
+// batch_input fills in with n time values: mostly increasing timestamps
+// around the present, mixed with values far in the past and in the future.
+static void batch_input(Time* in, size_t n) {
+    uint64_t x = 42;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t r = batch_rand(&x);
+        if (i % 97 == 0) {
+            in[i] = (Time){(int64_t)r, 0};  // anywhere in the supported range
+        } else if (i % 31 == 0) {
+            in[i] = time_unix((int64_t)(r >> 28) - (INT64_C(1) << 35), 0);  // ±1000 years
+        } else {
+            in[i] = time_unix(1700000000 + (int64_t)i * 7919, (int64_t)(r >> 34));
+        }
+    }
+}
+
+static void test_get_date_batch(void) {
+    printf("test_get_date_batch...");
+    enum { n = batch_size };
+    static Time in[n];
+    static int year[n], month[n], day[n];
+    batch_input(in, n);
+    for (size_t j = 0; j < sizeof(batch_sizes) / sizeof(batch_sizes[0]); j++) {
+        size_t k = batch_sizes[j];
+        time_get_date_batch(in, k, year, month, day);
+        for (size_t i = 0; i < k; i++) {
+            int y, d;
+            enum Month m;
+            time_get_date(in[i], &y, &m, &d);
+            assert(year[i] == y && month[i] == (int)m && day[i] == d);
+        }
+    }
+    printf("OK\n");
+}
+
+static void test_get_clock_batch(void) {
+    printf("test_get_clock_batch...");
+    enum { n = batch_size };
+    static Time in[n];
+    static int hour[n], min[n], sec[n];
+    batch_input(in, n);
+    for (size_t j = 0; j < sizeof(batch_sizes) / sizeof(batch_sizes[0]); j++) {
+        size_t k = batch_sizes[j];
+        time_get_clock_batch(in, k, hour, min, sec);
+        for (size_t i = 0; i < k; i++) {
+            int h, m, s;
+            time_get_clock(in[i], &h, &m, &s);
+            assert(hour[i] == h && min[i] == m && sec[i] == s);
+        }
+    }
+    printf("OK\n");
+}
+
+static void test_get_weekday_batch(void) {
+    printf("test_get_weekday_batch...");
+    enum { n = batch_size };
+    static Time in[n];
+    static int weekday[n];
+    batch_input(in, n);
+    for (size_t j = 0; j < sizeof(batch_sizes) / sizeof(batch_sizes[0]); j++) {
+        size_t k = batch_sizes[j];
+        time_get_weekday_batch(in, k, weekday);
+        for (size_t i = 0; i < k; i++) {
+            assert(weekday[i] == (int)time_get_weekday(in[i]));
+        }
+    }
+    printf("OK\n");
+}
+
 // ## Unix time
 
 static bool same(Time t, ParsedTime u) {
@@ -639,6 +918,50 @@ static void test_add_date(void) {
     printf("OK\n");
 }
 
+typedef struct {
+    ParsedTime t;
+    Period p;
+    ParsedTime want;
+} AddPeriodTest;
+
+static AddPeriodTest add_period_tests[] = {
+    // exact part only
+    {{2011, 1, 31, 10, 0, 0, 0}, {0, 0, 0, 0}, {2011, 1, 31, 10, 0, 0, 0}},
+    {{2011, 1, 31, 10, 0, 0, 0}, {0, 0, 0, 90 * 60 * 1000000000LL}, {2011, 1, 31, 11, 30, 0, 0}},
+    {{2011, 1, 31, 10, 0, 0, 0}, {0, 0, 0, -1}, {2011, 1, 31, 9, 59, 59, 999999999}},
+    // days only
+    {{2011, 1, 31, 10, 0, 0, 0}, {0, 0, 1, 0}, {2011, 2, 1, 10, 0, 0, 0}},
+    {{2012, 2, 28, 23, 0, 0, 5}, {0, 0, 1, 3600 * 1000000000LL}, {2012, 3, 1, 0, 0, 0, 5}},
+    {{2011, 1, 1, 0, 0, 0, 0}, {0, 0, -365, 0}, {2010, 1, 1, 0, 0, 0, 0}},
+    // calendar part normalizes like time_add_date
+    {{2011, 1, 31, 10, 0, 0, 0}, {0, 1, 0, 3600 * 1000000000LL}, {2011, 3, 3, 11, 0, 0, 0}},
+    {{2011, 10, 31, 0, 0, 0, 0}, {0, 1, 0, 0}, {2011, 12, 1, 0, 0, 0, 0}},
+    {{2012, 2, 29, 12, 0, 0, 0}, {1, 0, 0, 0}, {2013, 3, 1, 12, 0, 0, 0}},
+    {{2011, 11, 18, 7, 56, 35, 0}, {4, 4, 1, 0}, {2016, 3, 19, 7, 56, 35, 0}},
+    {{2011, 1, 1, 0, 0, 0, 0}, {-1, 2, 3, 0}, {2010, 3, 4, 0, 0, 0, 0}},
+    // calendar part first, then exact part
+    {{2011, 1, 31, 23, 0, 0, 0}, {0, 1, 0, 2 * 3600 * 1000000000LL}, {2011, 3, 4, 1, 0, 0, 0}},
+};
+
+static void test_add_period(void) {
+    printf("test_add_period...");
+    for (size_t i = 0; i < sizeof(add_period_tests) / sizeof(add_period_tests[0]); i++) {
+        AddPeriodTest test = add_period_tests[i];
+        Time t = time_date(test.t.year, test.t.month, test.t.day, test.t.hour, test.t.min,
+                           test.t.sec, test.t.nsec, 0);
+        Time want = time_date(test.want.year, test.want.month, test.want.day, test.want.hour,
+                              test.want.min, test.want.sec, test.want.nsec, 0);
+        Time got = time_add_period(t, test.p);
+        assert(time_equal(got, want));
+
+        // Same as adding the calendar part, then the exact part.
+        Time seq = time_add(time_add_date(t, test.p.years, test.p.months, test.p.days),
+                            test.p.duration);
+        assert(time_equal(got, seq));
+    }
+    printf("OK\n");
+}
+
 // ## Rounding
 
 typedef struct {
@@ -738,14 +1061,132 @@ static void test_marshal_binary(void) {
     printf("OK\n");
 }
 
+static void test_marshal_binary_batch(void) {
+    printf("test_marshal_binary_batch...");
+    enum { n = sizeof(unix_tests) / sizeof(unix_tests[0]) };
+    Time in[n];
+    for (size_t i = 0; i < n; i++) {
+        in[i] = time_unix(unix_tests[i].sec, unix_tests[i].nsec);
+    }
+
+    uint8_t buf[n * TIME_BINARY_SIZE];
+    time_marshal_binary_batch(in, n, buf);
+    for (size_t i = 0; i < n; i++) {
+        uint8_t blob[TIME_BINARY_SIZE];
+        time_marshal_binary(in[i], blob);
+        assert(memcmp(buf + i * TIME_BINARY_SIZE, blob, TIME_BINARY_SIZE) == 0);
+    }
+
+    Time out[n];
+    time_unmarshal_binary_batch(buf, n, out);
+    for (size_t i = 0; i < n; i++) {
+        assert(time_equal(out[i], in[i]));
+    }
+
+    // Unknown version.
+    buf[TIME_BINARY_SIZE] = 2;
+    time_unmarshal_binary_batch(buf, 2, out);
+    assert(time_equal(out[0], in[0]));
+    assert(time_is_zero(out[1]));
+
+    // Empty input.
+    time_marshal_binary_batch(in, 0, NULL);
+    time_unmarshal_binary_batch(NULL, 0, out);
+    printf("OK\n");
+}
+
+// key_times are in increasing order.
+static Time key_times[] = {
+    {INT64_MIN, 0},
+    {INT64_MIN, 999999999},
+    {INT64_MIN + 1, 0},
+    {-4294967296, 0},
+    {-4294967295, 5},
+    {-256, 999999999},
+    {-255, 0},
+    {-1, 0},
+    {-1, 1},
+    {-1, 999999999},
+    {0, 0},
+    {0, 1},
+    {0, 256},
+    {1, 0},
+    {255, 999999999},
+    {256, 0},
+    {63082281600, 0},  // 2000-01-01
+    {63082281600, 500000000},
+    {4294967296, 0},
+    {INT64_MAX - 1, 999999999},
+    {INT64_MAX, 0},
+    {INT64_MAX, 999999999},
+};
+
+// sign returns the sign of x.
+static int sign(int x) {
+    return (x > 0) - (x < 0);
+}
+
+static void test_marshal_key(void) {
+    printf("test_marshal_key...");
+    enum { n = sizeof(key_times) / sizeof(key_times[0]) };
+    uint8_t keys[n][TIME_KEY_SIZE];
+    for (size_t i = 0; i < n; i++) {
+        time_marshal_key(key_times[i], keys[i]);
+        assert(time_equal(time_unmarshal_key(keys[i]), key_times[i]));
+    }
+
+    // Keys compare like the time values.
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            int want = time_compare(key_times[i], key_times[j]);
+            assert(sign(memcmp(keys[i], keys[j], TIME_KEY_SIZE)) == want);
+        }
+    }
+
+    // The zero time.
+    uint8_t zero[TIME_KEY_SIZE] = {0x80};
+    time_marshal_key((Time){0, 0}, keys[0]);
+    assert(memcmp(keys[0], zero, TIME_KEY_SIZE) == 0);
+    printf("OK\n");
+}
+
+static void test_marshal_key_batch(void) {
+    printf("test_marshal_key_batch...");
+    enum { n = sizeof(key_times) / sizeof(key_times[0]) };
+    uint8_t buf[n * TIME_KEY_SIZE];
+    time_marshal_key_batch(key_times, n, buf);
+    for (size_t i = 0; i < n; i++) {
+        uint8_t key[TIME_KEY_SIZE];
+        time_marshal_key(key_times[i], key);
+        assert(memcmp(buf + i * TIME_KEY_SIZE, key, TIME_KEY_SIZE) == 0);
+    }
+
+    Time out[n];
+    time_unmarshal_key_batch(buf, n, out);
+    for (size_t i = 0; i < n; i++) {
+        assert(time_equal(out[i], key_times[i]));
+    }
+
+    // Empty input.
+    time_marshal_key_batch(key_times, 0, NULL);
+    time_unmarshal_key_batch(NULL, 0, out);
+    printf("OK\n");
+}
+
 int main(void) {
     // Constructors.
     test_date();
+    test_date_batch();
 
     // Time parts.
     test_get_part();
     test_get_isoweek();
     test_get_yearday();
+    test_get_fields();
+    test_calendar_sweep();
+    test_get_date_batch();
+    test_get_clock_batch();
+    test_get_weekday_batch();
 
     // Unix time.
     test_unix();
@@ -769,6 +1210,7 @@ int main(void) {
     test_add_to_exact_second();
     test_sub();
     test_add_date();
+    test_add_period();
 
     // Rounding.
     test_truncate();
@@ -776,4 +1218,7 @@ int main(void) {
 
     // Marshaling.
     test_marshal_binary();
+    test_marshal_binary_batch();
+    test_marshal_key();
+    test_marshal_key_batch();
 }